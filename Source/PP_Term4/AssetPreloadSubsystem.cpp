@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AssetPreloadSubsystem.h"
+#include "PP_Term4.h"
+#include "Engine/GameInstance.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+
+static TAutoConsoleVariable<bool> CVarPreloadSynchronous(
+	TEXT("thelab.Preload.Synchronous"),
+	false,
+	TEXT("Loads the soft referenced gameplay assets when they are requested, blocking the frame (for comparing with the background loading)."));
+
+// Console command to print how long the preloads took
+static FAutoConsoleCommandWithWorld GPreloadStatsCommand(
+	TEXT("thelab.Preload.Stats"),
+	TEXT("Logs the preload requests, the loaded assets and the time from a request to its callback."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UAssetPreloadSubsystem* AssetPreload = UAssetPreloadSubsystem::Get(World))
+			AssetPreload->LogStats();
+	}));
+
+void UAssetPreloadSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	NumRequests = 0;
+	NumAssets = 0;
+	NumLoaded = 0;
+	TotalWaitSeconds = 0.0;
+	LongestWaitSeconds = 0.0;
+}
+
+UAssetPreloadSubsystem* UAssetPreloadSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UGameInstance* GameInstance = UGameplayStatics::GetGameInstance(WorldContextObject);
+	return GameInstance ? GameInstance->GetSubsystem<UAssetPreloadSubsystem>() : nullptr;
+}
+
+TSharedPtr<FStreamableHandle> UAssetPreloadSubsystem::Preload(const TArray<FSoftObjectPath>& Assets, FOnAssetsPreloaded OnLoaded, bool bHighPriority)
+{
+	// Properties that weren't set in the blueprint
+	TArray<FSoftObjectPath> Paths;
+
+	for (const FSoftObjectPath& Asset : Assets)
+	{
+		if (!Asset.IsNull())
+			Paths.Add(Asset);
+	}
+
+	if (Paths.Num() == 0)
+	{
+		OnLoaded.ExecuteIfBound();
+		return nullptr;
+	}
+
+	NumRequests++;
+	NumAssets += Paths.Num();
+
+	const double RequestTime = FPlatformTime::Seconds();
+
+	if (CVarPreloadSynchronous.GetValueOnGameThread())
+	{
+		TSharedPtr<FStreamableHandle> Handle = StreamableManager.RequestSyncLoad(Paths, false, TEXT("TheLabPreload"));
+
+		OnPreloaded(MoveTemp(OnLoaded), RequestTime);
+
+		return Handle;
+	}
+
+	// The HUD of the round comes before what is only needed at its end
+	const TAsyncLoadPriority Priority = bHighPriority ? FStreamableManager::AsyncLoadHighPriority : FStreamableManager::DefaultAsyncLoadPriority;
+
+	return StreamableManager.RequestAsyncLoad(Paths, FStreamableDelegate::CreateUObject(this, &UAssetPreloadSubsystem::OnPreloaded, OnLoaded, RequestTime), Priority, false, false, TEXT("TheLabPreload"));
+}
+
+void UAssetPreloadSubsystem::OnPreloaded(FOnAssetsPreloaded OnLoaded, double RequestTime)
+{
+	const double WaitSeconds = FPlatformTime::Seconds() - RequestTime;
+
+	TotalWaitSeconds += WaitSeconds;
+	LongestWaitSeconds = FMath::Max(LongestWaitSeconds, WaitSeconds);
+
+	NumLoaded++;
+
+	// The requester may be gone by now, then it doesn't need the assets anymore
+	OnLoaded.ExecuteIfBound();
+}
+
+void UAssetPreloadSubsystem::LogStats() const
+{
+	// Requests of actors that were destroyed while loading never finish
+	UE_LOG(LogTheLab, Log, TEXT("Preloads: %d requests for %d assets, %d finished, %.2f ms average and %.2f ms longest from request to callback (%s)"),
+		NumRequests, NumAssets, NumLoaded,
+		NumLoaded > 0 ? TotalWaitSeconds * 1000.0 / NumLoaded : 0.0, LongestWaitSeconds * 1000.0,
+		CVarPreloadSynchronous.GetValueOnGameThread() ? TEXT("synchronous") : TEXT("background"));
+}
@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Engine/StreamableManager.h"
+
+#include "AssetPreloadSubsystem.generated.h"
+
+DECLARE_DELEGATE(FOnAssetsPreloaded);
+
+/**
+ * Loads the soft referenced assets of the gameplay classes in the background once they begin play, instead of
+ * loading everything they reference with their blueprint.
+ * The assets stay in memory while the requester holds the returned handle, so they are released with the actor
+ * that asked for them (a streamed mini-game doesn't keep its UI loaded in the hub).
+ * thelab.Preload.Synchronous 1 loads them on request instead, for comparing the map load times.
+ */
+UCLASS()
+class PP_TERM4_API UAssetPreloadSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	static UAssetPreloadSubsystem* Get(const UObject* WorldContextObject);
+
+	// Starts loading the assets and calls OnLoaded on the game thread once all of them are in memory
+	// (null paths are skipped, the handle is invalid when there is nothing to load and OnLoaded is called right away)
+	TSharedPtr<FStreamableHandle> Preload(const TArray<FSoftObjectPath>& Assets, FOnAssetsPreloaded OnLoaded, bool bHighPriority = false);
+
+	void LogStats() const;
+
+private:
+	void OnPreloaded(FOnAssetsPreloaded OnLoaded, double RequestTime);
+
+	FStreamableManager StreamableManager;
+
+	// Counters
+	int32 NumRequests;
+	int32 NumAssets;
+	int32 NumLoaded;
+
+	// Seconds from the request to the callback
+	double TotalWaitSeconds;
+	double LongestWaitSeconds;
+};
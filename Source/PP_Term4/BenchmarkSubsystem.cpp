@@ -0,0 +1,441 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BenchmarkSubsystem.h"
+#include "PP_Term4.h"
+#include "InteractionSubsystem.h"
+#include "TheLabCollision.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/ActorComponent.h"
+#include "Dom/JsonObject.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/PlatformMemory.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "UObject/UObjectGlobals.h"
+
+// Longest time a map may take to load before it is reported as failed
+static const float MaxLoadSeconds = 120.0f;
+
+// Time between two counts of the overlaps, so counting them doesn't show in the frame time
+static const float OverlapSampleInterval = 0.25f;
+
+// Turn rate of the scripted path, the pawn runs in circles around its start (degrees per second)
+static const float PathTurnRate = 45.0f;
+
+const double* FBenchmarkMapResult::Find(const FString& Name) const
+{
+	for (const TPair<FString, double>& Metric : Metrics)
+	{
+		if (Metric.Key == Name)
+			return &Metric.Value;
+	}
+
+	return nullptr;
+}
+
+bool UBenchmarkSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return FParse::Param(FCommandLine::Get(), TEXT("TheLabBenchmark"));
+}
+
+void UBenchmarkSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+
+	// Settings
+	FString MapList = TEXT("MainMenu+ThirdPersonMap_2+Game1+Game2");
+	FParse::Value(CommandLine, TEXT("BenchmarkMaps="), MapList);
+	MapList.ParseIntoArray(Maps, TEXT("+"));
+
+	WarmupSeconds = 3.0f;
+	MeasureSeconds = 20.0f;
+	Threshold = 0.1;
+	ReportPath = FPaths::ProjectSavedDir() / TEXT("Benchmark") / TEXT("Report");
+
+	FParse::Value(CommandLine, TEXT("BenchmarkWarmup="), WarmupSeconds);
+	FParse::Value(CommandLine, TEXT("BenchmarkSeconds="), MeasureSeconds);
+	FParse::Value(CommandLine, TEXT("BenchmarkReport="), ReportPath);
+	FParse::Value(CommandLine, TEXT("BenchmarkBaseline="), BaselinePath);
+	FParse::Value(CommandLine, TEXT("BenchmarkThreshold="), Threshold);
+
+	// Start once the default map is running
+	Phase = Maps.Num() > 0 ? EPhase::Starting : EPhase::Idle;
+	MapIndex = -1;
+	PhaseTime = 0.0f;
+	NumSpawned = 0;
+	StartUsedPhysical = 0;
+	NumMeasuredFrames = 0;
+	OverlapSampleTime = 0.0f;
+	TotalOverlaps = 0;
+	NumOverlapSamples = 0;
+	bCountedOverlaps = false;
+
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &UBenchmarkSubsystem::OnPostLoadMap);
+
+	UE_LOG(LogTheLab, Log, TEXT("Benchmark of %d maps (%.0f s warm-up, %.0f s measured, collision profiles %s)"),
+		Maps.Num(), WarmupSeconds, MeasureSeconds, FTheLabCollision::AreProfilesEnabled() ? TEXT("on") : TEXT("off"));
+}
+
+void UBenchmarkSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+
+	if (UWorld* World = BenchmarkWorld.Get())
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+
+	Super::Deinitialize();
+}
+
+void UBenchmarkSubsystem::Tick(float DeltaTime)
+{
+	PhaseTime += DeltaTime;
+
+	switch (Phase)
+	{
+	case EPhase::Starting:
+		if (GetGameInstance()->GetWorld())
+			OpenNextMap();
+		break;
+
+	case EPhase::Loading:
+		if (PhaseTime > MaxLoadSeconds)
+		{
+			UE_LOG(LogTheLab, Error, TEXT("Benchmark map %s didn't load"), *Maps[MapIndex]);
+
+			Results.SetNum(MapIndex + 1);
+			Results[MapIndex].MapName = Maps[MapIndex];
+
+			OpenNextMap();
+		}
+		break;
+
+	case EPhase::Warmup:
+		DrivePlayer(DeltaTime);
+
+		if (PhaseTime >= WarmupSeconds)
+			BeginMeasuring();
+		break;
+
+	case EPhase::Measuring:
+		DrivePlayer(DeltaTime);
+
+		// Game thread cost of the previous frame, without the time spent waiting for the frame rate limit
+		// (not when that frame counted the overlaps, the count isn't part of the game)
+		if (!bCountedOverlaps)
+			FrameMilliseconds.Add((FApp::GetDeltaTime() - FApp::GetIdleTime()) * 1000.0f);
+
+		NumMeasuredFrames++;
+		OverlapSampleTime += DeltaTime;
+		bCountedOverlaps = OverlapSampleTime >= OverlapSampleInterval;
+
+		if (bCountedOverlaps)
+		{
+			OverlapSampleTime = 0.0f;
+			TotalOverlaps += CountOverlaps();
+			NumOverlapSamples++;
+		}
+
+		if (PhaseTime >= MeasureSeconds)
+		{
+			FinishMap();
+			OpenNextMap();
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+bool UBenchmarkSubsystem::IsTickable() const
+{
+	return Phase != EPhase::Idle;
+}
+
+TStatId UBenchmarkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBenchmarkSubsystem, STATGROUP_Tickables);
+}
+
+void UBenchmarkSubsystem::AddMetric(const FString& Name, double Value)
+{
+	if (Phase == EPhase::Measuring && Results.IsValidIndex(MapIndex))
+		Results[MapIndex].Add(Name, Value);
+}
+
+void UBenchmarkSubsystem::OpenNextMap()
+{
+	if (UWorld* World = BenchmarkWorld.Get())
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+
+	BenchmarkWorld.Reset();
+	MapIndex++;
+
+	if (MapIndex >= Maps.Num())
+	{
+		FinishBenchmark();
+		return;
+	}
+
+	Phase = EPhase::Loading;
+	PhaseTime = 0.0f;
+
+	UGameplayStatics::OpenLevel(GetGameInstance()->GetWorld(), FName(*Maps[MapIndex]));
+}
+
+void UBenchmarkSubsystem::OnPostLoadMap(UWorld* World)
+{
+	if (Phase != EPhase::Loading || !World || World->GetName() != Maps[MapIndex])
+		return;
+
+	BenchmarkWorld = World;
+	ActorSpawnedHandle = World->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UBenchmarkSubsystem::OnActorSpawned));
+
+	Phase = EPhase::Warmup;
+	PhaseTime = 0.0f;
+}
+
+void UBenchmarkSubsystem::OnActorSpawned(AActor* Actor)
+{
+	if (Phase == EPhase::Measuring)
+		NumSpawned++;
+}
+
+void UBenchmarkSubsystem::BeginMeasuring()
+{
+	Phase = EPhase::Measuring;
+	PhaseTime = 0.0f;
+
+	FrameMilliseconds.Reset();
+	NumSpawned = 0;
+	StartUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+
+	NumMeasuredFrames = 0;
+	OverlapSampleTime = 0.0f;
+	TotalOverlaps = 0;
+	NumOverlapSamples = 0;
+	bCountedOverlaps = false;
+
+	if (UInteractionSubsystem* InteractionSubsystem = BenchmarkWorld->GetSubsystem<UInteractionSubsystem>())
+		InteractionSubsystem->ResetOverlapCallbacks();
+
+	// Results are indexed by map, AddMetric may be called from now on
+	Results.SetNum(MapIndex + 1);
+	Results[MapIndex].MapName = Maps[MapIndex];
+	Results[MapIndex].bLoaded = true;
+}
+
+void UBenchmarkSubsystem::FinishMap()
+{
+	FBenchmarkMapResult& Result = Results[MapIndex];
+
+	// Frame time percentiles
+	FrameMilliseconds.Sort();
+
+	const auto Percentile = [this](float Fraction)
+	{
+		const int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * FrameMilliseconds.Num()) - 1, 0, FrameMilliseconds.Num() - 1);
+		return FrameMilliseconds.Num() > 0 ? (double)FrameMilliseconds[Index] : 0.0;
+	};
+
+	double TotalMilliseconds = 0.0;
+
+	for (const float Milliseconds : FrameMilliseconds)
+		TotalMilliseconds += Milliseconds;
+
+	Result.Add(TEXT("frame_ms_mean"), FrameMilliseconds.Num() > 0 ? TotalMilliseconds / FrameMilliseconds.Num() : 0.0);
+	Result.Add(TEXT("frame_ms_p50"), Percentile(0.5f));
+	Result.Add(TEXT("frame_ms_p90"), Percentile(0.9f));
+	Result.Add(TEXT("frame_ms_p99"), Percentile(0.99f));
+	Result.Add(TEXT("frame_ms_max"), Percentile(1.0f));
+
+	// Ticking actors and components at the end of the run
+	int32 NumActors = 0;
+	int32 NumTickingActors = 0;
+	int32 NumTickingComponents = 0;
+
+	for (TActorIterator<AActor> It(BenchmarkWorld.Get()); It; ++It)
+	{
+		NumActors++;
+
+		if (It->IsActorTickEnabled())
+			NumTickingActors++;
+
+		for (const UActorComponent* Component : It->GetComponents())
+		{
+			if (Component && Component->IsComponentTickEnabled())
+				NumTickingComponents++;
+		}
+	}
+
+	Result.Add(TEXT("actors"), NumActors);
+	Result.Add(TEXT("ticking_actors"), NumTickingActors);
+	Result.Add(TEXT("ticking_components"), NumTickingComponents);
+	Result.Add(TEXT("spawned_actors"), NumSpawned);
+
+	// Overlaps, and the overlap callbacks of the player characters (the ignored ones were for actors they don't interact with)
+	Result.Add(TEXT("overlaps_mean"), NumOverlapSamples > 0 ? (double)TotalOverlaps / NumOverlapSamples : 0.0);
+
+	if (const UInteractionSubsystem* InteractionSubsystem = BenchmarkWorld->GetSubsystem<UInteractionSubsystem>())
+	{
+		const double NumFrames = FMath::Max(NumMeasuredFrames, 1);
+
+		Result.Add(TEXT("overlap_callbacks_per_frame"), InteractionSubsystem->GetNumOverlapCallbacks() / NumFrames);
+		Result.Add(TEXT("ignored_overlap_callbacks_per_frame"), InteractionSubsystem->GetNumIgnoredOverlapCallbacks() / NumFrames);
+	}
+
+	// Memory
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+
+	Result.Add(TEXT("used_physical_mb"), MemoryStats.UsedPhysical / (1024.0 * 1024.0));
+	Result.Add(TEXT("used_physical_growth_mb"), ((double)MemoryStats.UsedPhysical - (double)StartUsedPhysical) / (1024.0 * 1024.0));
+
+	UE_LOG(LogTheLab, Log, TEXT("Benchmark %s: %d frames, p50 %.2f ms, p99 %.2f ms"), *Result.MapName, FrameMilliseconds.Num(), Percentile(0.5f), Percentile(0.99f));
+}
+
+void UBenchmarkSubsystem::FinishBenchmark()
+{
+	Phase = EPhase::Idle;
+
+	bool bFailed = !WriteReport();
+
+	for (const FBenchmarkMapResult& Result : Results)
+		bFailed |= !Result.bLoaded;
+
+	if (!BaselinePath.IsEmpty())
+		bFailed |= !CompareWithBaseline();
+
+	UE_LOG(LogTheLab, Log, TEXT("Benchmark %s"), bFailed ? TEXT("failed") : TEXT("passed"));
+
+	FPlatformMisc::RequestExitWithStatus(false, bFailed ? 1 : 0);
+}
+
+int32 UBenchmarkSubsystem::CountOverlaps() const
+{
+	int32 NumOverlaps = 0;
+
+	for (TActorIterator<AActor> It(BenchmarkWorld.Get()); It; ++It)
+	{
+		TInlineComponentArray<UPrimitiveComponent*> Primitives(*It);
+
+		for (const UPrimitiveComponent* Primitive : Primitives)
+			NumOverlaps += Primitive->GetOverlapInfos().Num();
+	}
+
+	return NumOverlaps;
+}
+
+void UBenchmarkSubsystem::DrivePlayer(float DeltaTime)
+{
+	APlayerController* PlayerController = GetGameInstance()->GetFirstLocalPlayerController(BenchmarkWorld.Get());
+	APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+
+	if (!Pawn)
+		return;
+
+	// Same path on every run: full speed ahead while turning at a fixed rate
+	const FRotator Direction(0.0f, FMath::Fmod(PhaseTime * PathTurnRate, 360.0f), 0.0f);
+
+	PlayerController->SetControlRotation(Direction);
+	Pawn->AddMovementInput(Direction.Vector(), 1.0f);
+}
+
+bool UBenchmarkSubsystem::WriteReport() const
+{
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	TArray<TSharedPtr<FJsonValue>> MapValues;
+
+	FString Csv = TEXT("map,metric,value\n");
+
+	for (const FBenchmarkMapResult& Result : Results)
+	{
+		TSharedRef<FJsonObject> MapObject = MakeShared<FJsonObject>();
+		TSharedRef<FJsonObject> MetricsObject = MakeShared<FJsonObject>();
+
+		for (const TPair<FString, double>& Metric : Result.Metrics)
+		{
+			MetricsObject->SetNumberField(Metric.Key, Metric.Value);
+			Csv += FString::Printf(TEXT("%s,%s,%f\n"), *Result.MapName, *Metric.Key, Metric.Value);
+		}
+
+		MapObject->SetStringField(TEXT("map"), Result.MapName);
+		MapObject->SetBoolField(TEXT("loaded"), Result.bLoaded);
+		MapObject->SetObjectField(TEXT("metrics"), MetricsObject);
+
+		MapValues.Add(MakeShared<FJsonValueObject>(MapObject));
+	}
+
+	Report->SetNumberField(TEXT("version"), 1);
+	Report->SetNumberField(TEXT("warmup_seconds"), WarmupSeconds);
+	Report->SetNumberField(TEXT("measure_seconds"), MeasureSeconds);
+	Report->SetArrayField(TEXT("maps"), MapValues);
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Report, Writer);
+
+	const bool bWritten = FFileHelper::SaveStringToFile(Json, *(ReportPath + TEXT(".json"))) && FFileHelper::SaveStringToFile(Csv, *(ReportPath + TEXT(".csv")));
+
+	if (bWritten)
+		UE_LOG(LogTheLab, Log, TEXT("Benchmark report written to %s.json/.csv"), *ReportPath);
+	else
+		UE_LOG(LogTheLab, Error, TEXT("Couldn't write benchmark report %s"), *ReportPath);
+
+	return bWritten;
+}
+
+bool UBenchmarkSubsystem::CompareWithBaseline() const
+{
+	FString Json;
+	TSharedPtr<FJsonObject> Baseline;
+
+	if (!FFileHelper::LoadFileToString(Json, *BaselinePath) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Baseline) || !Baseline.IsValid())
+	{
+		UE_LOG(LogTheLab, Error, TEXT("Couldn't read benchmark baseline %s"), *BaselinePath);
+		return false;
+	}
+
+	int32 NumRegressions = 0;
+
+	for (const TSharedPtr<FJsonValue>& MapValue : Baseline->GetArrayField(TEXT("maps")))
+	{
+		const TSharedPtr<FJsonObject> MapObject = MapValue->AsObject();
+		const FString MapName = MapObject->GetStringField(TEXT("map"));
+
+		const FBenchmarkMapResult* Result = Results.FindByPredicate([&MapName](const FBenchmarkMapResult& Candidate) { return Candidate.MapName == MapName; });
+
+		if (!Result)
+			continue;
+
+		// Metrics are lower is better, a zero baseline can't regress by a fraction
+		for (const TPair<FString, TSharedPtr<FJsonValue>>& Metric : MapObject->GetObjectField(TEXT("metrics"))->Values)
+		{
+			const double BaselineValue = Metric.Value->AsNumber();
+			const double* Value = Result->Find(Metric.Key);
+
+			if (!Value || BaselineValue <= 0.0 || *Value <= BaselineValue * (1.0 + Threshold))
+				continue;
+
+			UE_LOG(LogTheLab, Error, TEXT("Benchmark regression %s %s: %.3f (baseline %.3f, +%.0f%%)"),
+				*MapName, *Metric.Key, *Value, BaselineValue, (*Value / BaselineValue - 1.0) * 100.0);
+
+			NumRegressions++;
+		}
+	}
+
+	UE_LOG(LogTheLab, Log, TEXT("Benchmark compared with %s: %d regressions past %.0f%%"), *BaselinePath, NumRegressions, Threshold * 100.0);
+
+	return NumRegressions == 0;
+}
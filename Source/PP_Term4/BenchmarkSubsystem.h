@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tickable.h"
+
+#include "BenchmarkSubsystem.generated.h"
+
+class UWorld;
+
+// Measurements of one map (every metric is lower is better)
+struct FBenchmarkMapResult
+{
+	FString MapName;
+	bool bLoaded = false;
+
+	// Metric name to value, in the order they were added
+	TArray<TPair<FString, double>> Metrics;
+
+	void Add(const FString& Name, double Value) { Metrics.Emplace(Name, Value); }
+	const double* Find(const FString& Name) const;
+};
+
+/**
+ * Headless benchmark of the maps of the game, only created when the game runs with -TheLabBenchmark.
+ * Every map is opened in turn, the player pawn is driven along a scripted path, and the game thread frame time,
+ * tick and spawn counts, overlaps and memory are recorded. The report is written as JSON and CSV, and compared with a
+ * baseline report when one is given. The process exits with code 1 when a metric regressed past the threshold.
+ *
+ * UnrealEditor PP_Term4 -game -nullrhi -unattended -nosound -TheLabBenchmark
+ *   -BenchmarkMaps=MainMenu+ThirdPersonMap_2+Game1+Game2  Maps to run (default: all four)
+ *   -BenchmarkSeconds=20 -BenchmarkWarmup=3               Measured and warm-up seconds per map
+ *   -BenchmarkReport=<path without extension>             Default: Saved/Benchmark/Report
+ *   -BenchmarkBaseline=<report.json> -BenchmarkThreshold=0.1
+ *   -dpcvars=thelab.Collision.Profiles=0                  Measures the overlaps with the collision of the blueprints
+ */
+UCLASS()
+class PP_TERM4_API UBenchmarkSubsystem : public UGameInstanceSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+
+	// Adds a metric to the map that is being measured (for systems that report their own counters)
+	void AddMetric(const FString& Name, double Value);
+
+	bool IsRunning() const { return Phase != EPhase::Idle; }
+
+private:
+	enum class EPhase : uint8
+	{
+		Idle,
+		Starting,
+		Loading,
+		Warmup,
+		Measuring
+	};
+
+	void OpenNextMap();
+	void OnPostLoadMap(UWorld* World);
+	void OnActorSpawned(AActor* Actor);
+
+	void BeginMeasuring();
+	void FinishMap();
+	void FinishBenchmark();
+
+	// Moves the player pawn along the scripted path
+	void DrivePlayer(float DeltaTime);
+
+	// Overlaps the components of the world track (a pair of components that both generate overlap events counts twice)
+	int32 CountOverlaps() const;
+
+	bool WriteReport() const;
+	bool CompareWithBaseline() const;
+
+	// Settings
+	TArray<FString> Maps;
+	float WarmupSeconds;
+	float MeasureSeconds;
+	FString ReportPath;
+	FString BaselinePath;
+	double Threshold;
+
+	// Progress
+	EPhase Phase;
+	int32 MapIndex;
+	float PhaseTime;
+
+	TWeakObjectPtr<UWorld> BenchmarkWorld;
+	FDelegateHandle PostLoadMapHandle;
+	FDelegateHandle ActorSpawnedHandle;
+
+	// Samples of the map that is being measured
+	TArray<float> FrameMilliseconds;
+	int32 NumMeasuredFrames;
+	int32 NumSpawned;
+	uint64 StartUsedPhysical;
+
+	// Overlaps, sampled a few times a second
+	float OverlapSampleTime;
+	int64 TotalOverlaps;
+	int32 NumOverlapSamples;
+
+	// Whether this frame counted the overlaps, its time is left out of the frame samples
+	bool bCountedOverlaps;
+
+	TArray<FBenchmarkMapResult> Results;
+};
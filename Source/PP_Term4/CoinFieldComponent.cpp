@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoinFieldComponent.h"
+#include "TheLabCollision.h"
+
+// Sets default values for this component's properties
+UCoinFieldComponent::UCoinFieldComponent()
+{
+	// Only holds data, so it never has to tick
+	PrimaryComponentTick.bCanEverTick = false;
+
+	// The player overlaps the coins, nothing collides with them
+	SetCollisionProfileName(TEXT("OverlapAllDynamic"));
+	SetGenerateOverlapEvents(true);
+	SetCastShadow(false);
+
+	NumCustomDataFloats = 1;
+	NumCollected = 0;
+}
+
+// Called when the game starts
+void UCoinFieldComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// The coins are pickups, only the player characters overlap them
+	FTheLabCollision::ApplyInteractableProfile(this, EInteractionType::Coin);
+}
+
+void UCoinFieldComponent::AddCoins(const TArray<FVector>& Locations, FRandomStream& Random)
+{
+	if (Locations.Num() == 0)
+		return;
+
+	const int32 FirstIndex = CoinTransforms.Num();
+
+	CoinTransforms.Reserve(FirstIndex + Locations.Num());
+
+	for (const FVector& Location : Locations)
+		CoinTransforms.Add(FTransform(FRotator::ZeroRotator, Location));
+
+	Collected.Add(false, Locations.Num());
+
+	// One batch for the render and physics state
+	TArray<FTransform> NewTransforms(&CoinTransforms[FirstIndex], Locations.Num());
+	AddInstances(NewTransforms, false, true);
+
+	for (int32 Index = FirstIndex; Index < CoinTransforms.Num(); Index++)
+		SetCustomDataValue(Index, 0, Random.GetFraction(), Index == CoinTransforms.Num() - 1);
+}
+
+bool UCoinFieldComponent::Collect(int32 InstanceIndex)
+{
+	if (!Collected.IsValidIndex(InstanceIndex) || Collected[InstanceIndex])
+		return false;
+
+	Collected[InstanceIndex] = true;
+	NumCollected++;
+
+	// A zero scale hides the instance and deletes its body, so it doesn't overlap anymore
+	FTransform Hidden = CoinTransforms[InstanceIndex];
+	Hidden.SetScale3D(FVector::ZeroVector);
+
+	UpdateInstanceTransform(InstanceIndex, Hidden, true, true, true);
+
+	return true;
+}
+
+void UCoinFieldComponent::ResetCoins()
+{
+	if (NumCollected == 0)
+		return;
+
+	for (TConstSetBitIterator<> It(Collected); It; ++It)
+		UpdateInstanceTransform(It.GetIndex(), CoinTransforms[It.GetIndex()], true, false, true);
+
+	Collected.Init(false, CoinTransforms.Num());
+	NumCollected = 0;
+
+	MarkRenderStateDirty();
+}
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/InstancedStaticMeshComponent.h"
+
+#include "CoinFieldComponent.generated.h"
+
+/**
+ * Renders every coin of a level as an instance of one mesh, instead of an actor per coin.
+ * The overlap events of the instances report the instance index, which is how a coin is collected.
+ * Collected coins are scaled to zero (which also removes their physics body) so the indices stay stable for a reset.
+ * Custom data 0 of every instance is a random phase in [0, 1), so the spin in the material isn't the same for every coin.
+ */
+UCLASS(ClassGroup = (TheLab), meta = (BlueprintSpawnableComponent))
+class PP_TERM4_API UCoinFieldComponent : public UInstancedStaticMeshComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UCoinFieldComponent();
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Adds the coins at the world locations
+	void AddCoins(const TArray<FVector>& Locations, FRandomStream& Random);
+
+	// Hides the coin of the instance (returns false when it was already collected)
+	bool Collect(int32 InstanceIndex);
+
+	// Shows every collected coin again
+	void ResetCoins();
+
+	int32 GetNumCoins() const { return CoinTransforms.Num(); }
+	int32 GetNumCollected() const { return NumCollected; }
+
+private:
+	// Transforms of the coins when they aren't collected
+	TArray<FTransform> CoinTransforms;
+
+	TBitArray<> Collected;
+	int32 NumCollected;
+};
@@ -1,275 +1,619 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-
-#include "CollectCharacter.h"
-
-// Sets default values
-ACollectCharacter::ACollectCharacter()
-{
-	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
-
-	// Set the size of the capsule
-	GetCapsuleComponent()->InitCapsuleSize(42.0f, 96.0f);
-
-	// Turns off the rotattion of the player (so that only camera moves)
-	bUseControllerRotationPitch = false;
-	bUseControllerRotationYaw = false;
-	bUseControllerRotationRoll = false;
-
-	GetCharacterMovement()->bOrientRotationToMovement = true;									// Allows the character movement to rotate in the direction it is moving
-	GetCharacterMovement()->RotationRate = FRotator(0.0f, 540.0f, 0.0f) * GetActorScale3D().X;	// The rate that is used for the rotation
-	GetCharacterMovement()->JumpZVelocity = 600.0f;												// Velocity when the player jumps
-	GetCharacterMovement()->AirControl = 0.2f;													// Control of the player in the air
-
-	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));				// Create cameraboom (springarm)
-	CameraBoom->SetupAttachment(RootComponent);													// Set it as a child of the capsule
-
-	CameraBoom->TargetArmLength = CameraBoom->TargetArmLength;									// How far the spring arm (camera) will be from the player
-	CameraBoom->bUsePawnControlRotation = true;													// Rotate the arm based on the controller
-
-	FollowCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));				// Create camera
-	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);					// Link the camera to the end of the springboom
-	FollowCamera->bUsePawnControlRotation = false;												// The camera doesn't rotate relative to the arm
-
-	// Set variables
-	pDead = false;
-	SprintSpeedMultiplier = 2.0f;
-	Health = 100.0f;
-	HealthDecreaseAmount = 5.0f;
-}
-
-// Called when the game starts or when spawned
-void ACollectCharacter::BeginPlay()
-{
-	Super::BeginPlay();
-
-	// Set the max walk speed of the character to the given max walk speed
-	GetCharacterMovement()->MaxWalkSpeed = pMaxWalkSpeed;
-
-	// Add the overlap event to the function
-	GetCapsuleComponent()->OnComponentBeginOverlap.AddDynamic(this, &ACollectCharacter::OnBeginOverlap);
-	GetCapsuleComponent()->OnComponentEndOverlap.AddDynamic(this, &ACollectCharacter::OnEndOverlap);
-
-	// Add the UI
-	if (Player_Health_Widget_Class)
-	{
-		Player_Health_Widget = CreateWidget(GetWorld(), Player_Health_Widget_Class);
-		Player_Health_Widget->AddToViewport();
-	}
-}
-
-// Called every frame
-void ACollectCharacter::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-
-	HandleTimer(DeltaTime);
-	HandleHP(DeltaTime);
-}
-
-// Called to bind functionality to input
-void ACollectCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
-{
-	Super::SetupPlayerInputComponent(PlayerInputComponent);
-
-	// Link the different inputs to the player input
-	PlayerInputComponent->BindAxis("Turn Right / Left Mouse", this, &APawn::AddControllerYawInput);
-	PlayerInputComponent->BindAxis("Look Up / Down Mouse", this, &APawn::AddControllerPitchInput);
-
-	PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &ACharacter::Jump);
-	PlayerInputComponent->BindAction("Jump", IE_Released, this, &ACharacter::StopJumping);
-
-
-	// Combine the axis to the function (executes when pressed)
-	PlayerInputComponent->BindAxis("Move Forward / Backward", this, &ACollectCharacter::MoveForward);
-	PlayerInputComponent->BindAxis("Move Right / Left", this, &ACollectCharacter::MoveRight);
-
-	PlayerInputComponent->BindAction("Sprint", IE_Pressed, this, &ACollectCharacter::Sprint);
-	PlayerInputComponent->BindAction("Sprint", IE_Released, this, &ACollectCharacter::StopSprinting);
-
-
-	// Combine the wheel axis to the camera move function
-	PlayerInputComponent->BindAxis("Wheel", this, &ACollectCharacter::MoveCamera);
-}
-
-#pragma region Movement
-
-void ACollectCharacter::MoveForward(float Axis)
-{
-	if (!pDead)
-	{
-		const FRotator Rotation = Controller->GetControlRotation();
-		const FRotator YawRotation(0, Rotation.Yaw, 0);
-
-		// Calculate the forward direction vector
-		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X);
-		AddMovementInput(Direction, Axis);
-	}
-}
-
-void ACollectCharacter::MoveRight(float Axis)
-{
-	if (!pDead)
-	{
-		const FRotator Rotation = Controller->GetControlRotation();
-		const FRotator YawRotation(0, Rotation.Yaw, 0);
-
-		// Calculate the right direction vector
-		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y);
-		AddMovementInput(Direction, Axis);
-	}
-}
-
-void ACollectCharacter::MoveCamera(float Axis)
-{
-	if (!pDead)
-	{
-		if (Axis == -1 && CameraBoom->TargetArmLength < 1000.0f)
-			CameraBoom->TargetArmLength += 20.0f;
-		else if (Axis == 1 && CameraBoom->TargetArmLength > 200.0f)
-			CameraBoom->TargetArmLength -= 20.0f;
-	}
-}
-
-void ACollectCharacter::Sprint()
-{
-	if (!pDead)
-		GetCharacterMovement()->MaxWalkSpeed = pMaxWalkSpeed * SprintSpeedMultiplier;
-}
-
-void ACollectCharacter::StopSprinting()
-{
-	GetCharacterMovement()->MaxWalkSpeed = pMaxWalkSpeed;
-}
-
-#pragma endregion
-
-#pragma region Overlap
-
-void ACollectCharacter::OnBeginOverlap(UPrimitiveComponent* HitComponent,
-	AActor* OtherActor, UPrimitiveComponent* OtherComponent, int32 OtherBodyIndex,
-	bool bFromSweep, const FHitResult& SweepResult)
-{
-	if (OtherActor->ActorHasTag("Recharge"))
-	{
-		Health += 10.0f;
-
-		if (Health > 100.0f)
-			Health = 100.0f;
-
-		OtherActor->Destroy();
-
-		// Spawn particle
-		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), PickingUpHealthEffect, GetActorLocation());
-	}
-}
-
-void ACollectCharacter::OnEndOverlap(class UPrimitiveComponent* OverlappedComp,
-	class AActor* OtherActor, class UPrimitiveComponent* OtherComp,
-	int32 OtherBodyIndex)
-{
-
-}
-
-#pragma endregion
-
-#pragma region Handlers
-
-void ACollectCharacter::HandleTimer(float pMinusAmount)
-{
-	if (!pDead)
-	{
-		if (timer > 0)
-			timer -= pMinusAmount;
-		else if (timer <= 0)
-		{
-			timer = 0;
-
-			if (Player_Won_Widget_Class)
-			{
-				Player_Won_Widget = CreateWidget(GetWorld(), Player_Won_Widget_Class);
-				Player_Won_Widget->AddToViewport();
-			}
-
-			FTimerHandle localHandler;
-			GetWorldTimerManager().SetTimer(localHandler, this, &ACollectCharacter::CallFadeOut_Won, 3.0f, false);
-		}
-	}
-}
-
-void ACollectCharacter::HandleHP(float pDeltaTime)
-{
-	if (timer > 0)
-		Health -= pDeltaTime * HealthDecreaseAmount;
-
-	if (Health <= 0)
-	{
-		if (!pDead)
-		{
-			pDead = true;
-			GetMesh()->SetSimulatePhysics(true);
-
-			if (Player_Lost_Widget_Class)
-			{
-				Player_Lost_Widget = CreateWidget(GetWorld(), Player_Lost_Widget_Class);
-				Player_Lost_Widget->AddToViewport();
-			}
-
-			FTimerHandle localHandler;
-			GetWorldTimerManager().SetTimer(localHandler, this, &ACollectCharacter::CallFadeOut_Lost, 3.0f, false);
-		}
-	}
-}
-
-#pragma endregion
-
-#pragma region Callers / Level Switchers / Data Savers
-
-void ACollectCharacter::CallFadeOut_Won()
-{
-	FOutputDeviceNull argument;
-	const FString command = FString::Printf(TEXT("SetFadeOut true"));
-
-	if (blueprintActor)
-		blueprintActor->CallFunctionByNameWithArguments(*command, argument, NULL, true);
-
-	level1Won = true;
-	CallSaveGameVariables();
-
-	FTimerHandle localHandler;
-	GetWorldTimerManager().SetTimer(localHandler, this, &ACollectCharacter::ToMainLevel, 0.83f, false);
-}
-
-void ACollectCharacter::CallFadeOut_Lost()
-{
-	FOutputDeviceNull argument;
-	const FString command = FString::Printf(TEXT("SetFadeOut true"));
-
-	if (blueprintActor)
-		blueprintActor->CallFunctionByNameWithArguments(*command, argument, NULL, true);
-
-	FTimerHandle localHandler;
-	GetWorldTimerManager().SetTimer(localHandler, this, &ACollectCharacter::RestartGame, 0.83f, false);
-}
-
-void ACollectCharacter::ToMainLevel()
-{
-	UGameplayStatics::OpenLevel(this, "ThirdPersonMap_2");
-}
-
-void ACollectCharacter::RestartGame()
-{
-	UGameplayStatics::OpenLevel(this, FName(*GetWorld()->GetName()), false);
-}
-
-void ACollectCharacter::CallSaveGameVariables()
-{
-	FOutputDeviceNull argument;
-	const FString command = FString::Printf(TEXT("SaveGame Slot1"));
-
-	if (blueprintActor)
-		blueprintActor->CallFunctionByNameWithArguments(*command, argument, NULL, true);
-}
-
-#pragma endregion
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CollectCharacter.h"
+#include "PP_Term4.h"
+#include "PickupPoolSubsystem.h"
+#include "TheLabCollision.h"
+#include "TheLabStats.h"
+#include "EngineUtils.h"
+
+// Sets default values
+ACollectCharacter::ACollectCharacter()
+{
+	// The round is event driven, so this character doesn't need to tick
+	PrimaryActorTick.bCanEverTick = false;
+
+	// Set the size of the capsule
+	GetCapsuleComponent()->InitCapsuleSize(42.0f, 96.0f);
+
+	// Turns off the rotattion of the player (so that only camera moves)
+	bUseControllerRotationPitch = false;
+	bUseControllerRotationYaw = false;
+	bUseControllerRotationRoll = false;
+
+	GetCharacterMovement()->bOrientRotationToMovement = true;									// Allows the character movement to rotate in the direction it is moving
+	GetCharacterMovement()->RotationRate = FRotator(0.0f, 540.0f, 0.0f) * GetActorScale3D().X;	// The rate that is used for the rotation
+	GetCharacterMovement()->JumpZVelocity = 600.0f;												// Velocity when the player jumps
+	GetCharacterMovement()->AirControl = 0.2f;													// Control of the player in the air
+
+	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));				// Create cameraboom (springarm)
+	CameraBoom->SetupAttachment(RootComponent);													// Set it as a child of the capsule
+
+	CameraBoom->TargetArmLength = CameraBoom->TargetArmLength;									// How far the spring arm (camera) will be from the player
+	CameraBoom->bUsePawnControlRotation = true;													// Rotate the arm based on the controller
+
+	FollowCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));				// Create camera
+	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);					// Link the camera to the end of the springboom
+	FollowCamera->bUsePawnControlRotation = false;												// The camera doesn't rotate relative to the arm
+
+	RoundState = CreateDefaultSubobject<URoundStateComponent>(TEXT("RoundState"));				// Create the round state
+	HUDData = CreateDefaultSubobject<UHUDDataComponent>(TEXT("HUDData"));						// Create the values of the HUD
+
+	// Set variables
+	pDead = false;
+	InteractionSubsystem = nullptr;
+	HUDWidgets = nullptr;
+	RoundReset = nullptr;
+	SprintSpeedMultiplier = 2.0f;
+	Health = 100.0f;
+	HealthDecreaseAmount = 5.0f;
+	CollectState = nullptr;
+	PlayedRound = 0;
+	bLocalViewSetUp = false;
+	StartHealth = Health;
+	RoundDuration = timer;
+}
+
+// Called when the game starts or when spawned
+void ACollectCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Set the max walk speed of the character to the given max walk speed
+	GetCharacterMovement()->MaxWalkSpeed = pMaxWalkSpeed;
+
+	// Only overlap the interactables, and add the overlap event to the function (nothing happens when leaving one)
+	FTheLabCollision::ApplyCharacterProfile(this);
+	GetCapsuleComponent()->OnComponentBeginOverlap.AddDynamic(this, &ACollectCharacter::OnBeginOverlap);
+
+	// Cache the interaction lookup used by the overlap events
+	InteractionSubsystem = GetWorld()->GetSubsystem<UInteractionSubsystem>();
+
+	// Let the pickup registry collect the pickups when it replaces the overlap events (it collects for one character)
+	UPickupRegistrySubsystem* PickupRegistry = GetWorld()->GetSubsystem<UPickupRegistrySubsystem>();
+
+	if (PickupRegistry && PickupRegistry->IsActive() && GetNetMode() == NM_Standalone)
+		PickupRegistry->SetCollector(this, FOnPickupCollected::CreateUObject(this, &ACollectCharacter::Interact));
+
+	// Create the pickup effects once the particles are loaded, so collecting doesn't create components
+	FeedbackEffects = GetWorld()->GetSubsystem<UFeedbackEffectsSubsystem>();
+
+	if (GetNetMode() != NM_DedicatedServer)
+		PickupAssets = UAssetPreloadSubsystem::Get(this)->Preload({ PickingUpHealthEffect.ToSoftObjectPath() }, FOnAssetsPreloaded::CreateUObject(this, &ACollectCharacter::OnPickupAssetsLoaded), true);
+
+	// Remember the start of the round for a retry
+	RoundReset = GetWorld()->GetSubsystem<URoundResetSubsystem>();
+	RoundReset->Capture(this);
+
+	StartHealth = Health;
+	RoundDuration = timer;
+
+	RoundState->OnStateChanged.AddUObject(this, &ACollectCharacter::OnRoundStateChanged);
+
+	SetupLocalView();
+	BindPlayerState();
+}
+
+// Called when the character is destroyed or its level is unloaded
+void ACollectCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// The widget pool outlives a streamed mini-game, so its UI has to leave with the character
+	if (UHUDWidgetSubsystem* WidgetPool = UHUDWidgetSubsystem::Get(this))
+	{
+		WidgetPool->Release(Player_Health_Widget_Class.Get());
+		WidgetPool->Release(Player_Won_Widget_Class.Get());
+		WidgetPool->Release(Player_Lost_Widget_Class.Get());
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ACollectCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+
+	BindPlayerState();
+}
+
+void ACollectCharacter::OnRep_PlayerState()
+{
+	Super::OnRep_PlayerState();
+
+	BindPlayerState();
+}
+
+void ACollectCharacter::NotifyControllerChanged()
+{
+	Super::NotifyControllerChanged();
+
+	// A client only knows it controls the character once the controller replicated
+	if (HasActorBegunPlay())
+		SetupLocalView();
+}
+
+// Called to bind functionality to input
+void ACollectCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
+{
+	Super::SetupPlayerInputComponent(PlayerInputComponent);
+
+	// The input goes through the replay subsystem, so it can be recorded and replayed
+	UInputReplaySubsystem* InputReplay = UInputReplaySubsystem::Get(this);
+
+	// Link the different inputs to the player input
+	InputReplay->BindAxis(PlayerInputComponent, "Turn Right / Left Mouse", this, &APawn::AddControllerYawInput);
+	InputReplay->BindAxis(PlayerInputComponent, "Look Up / Down Mouse", this, &APawn::AddControllerPitchInput);
+
+	InputReplay->BindAction(PlayerInputComponent, "Jump", IE_Pressed, this, &ACharacter::Jump);
+	InputReplay->BindAction(PlayerInputComponent, "Jump", IE_Released, this, &ACharacter::StopJumping);
+
+
+	// Combine the axis to the function (executes when pressed)
+	InputReplay->BindAxis(PlayerInputComponent, "Move Forward / Backward", this, &ACollectCharacter::MoveForward);
+	InputReplay->BindAxis(PlayerInputComponent, "Move Right / Left", this, &ACollectCharacter::MoveRight);
+
+	InputReplay->BindAction(PlayerInputComponent, "Sprint", IE_Pressed, this, &ACollectCharacter::Sprint);
+	InputReplay->BindAction(PlayerInputComponent, "Sprint", IE_Released, this, &ACollectCharacter::StopSprinting);
+
+
+	// Combine the wheel axis to the camera move function
+	InputReplay->BindAxis(PlayerInputComponent, "Wheel", this, &ACollectCharacter::MoveCamera);
+}
+
+#pragma region Movement
+
+void ACollectCharacter::MoveForward(float Axis)
+{
+	if (!pDead)
+		MovementInput.AddForward(Axis);
+}
+
+void ACollectCharacter::MoveRight(float Axis)
+{
+	if (!pDead)
+		MovementInput.AddRight(Axis);
+
+	// Bound after MoveForward, so this is the last movement axis of the frame
+	MovementInput.Flush(this);
+}
+
+void ACollectCharacter::MoveCamera(float Axis)
+{
+	if (!pDead)
+	{
+		if (Axis == -1 && CameraBoom->TargetArmLength < 1000.0f)
+			CameraBoom->TargetArmLength += 20.0f;
+		else if (Axis == 1 && CameraBoom->TargetArmLength > 200.0f)
+			CameraBoom->TargetArmLength -= 20.0f;
+	}
+}
+
+void ACollectCharacter::Sprint()
+{
+	if (!pDead)
+		GetCharacterMovement()->MaxWalkSpeed = pMaxWalkSpeed * SprintSpeedMultiplier;
+}
+
+void ACollectCharacter::StopSprinting()
+{
+	GetCharacterMovement()->MaxWalkSpeed = pMaxWalkSpeed;
+}
+
+#pragma endregion
+
+#pragma region Overlap
+
+void ACollectCharacter::OnBeginOverlap(UPrimitiveComponent* HitComponent,
+	AActor* OtherActor, UPrimitiveComponent* OtherComponent, int32 OtherBodyIndex,
+	bool bFromSweep, const FHitResult& SweepResult)
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_Overlap);
+
+	const EInteractionType Type = InteractionSubsystem->GetInteractionType(OtherActor);
+	InteractionSubsystem->RecordOverlapCallback(Type != EInteractionType::None);
+
+	Interact(OtherActor, Type);
+}
+
+void ACollectCharacter::OnEndOverlap(class UPrimitiveComponent* OverlappedComp,
+	class AActor* OtherActor, class UPrimitiveComponent* OtherComp,
+	int32 OtherBodyIndex)
+{
+
+}
+
+#pragma endregion
+
+#pragma region Interactions
+
+// Interaction handlers, indexed by interaction type
+const ACollectCharacter::FInteractionHandler ACollectCharacter::InteractionHandlers[] =
+{
+	nullptr,								// None
+	nullptr,								// Coin
+	&ACollectCharacter::CollectRecharge,	// Recharge
+	nullptr,								// Game1
+	nullptr,								// Game2
+	nullptr									// End
+};
+
+void ACollectCharacter::Interact(AActor* OtherActor, EInteractionType Type)
+{
+	static_assert(UE_ARRAY_COUNT(InteractionHandlers) == (uint8)EInteractionType::MAX, "Every interaction type needs an entry in InteractionHandlers");
+
+	if (const FInteractionHandler Handler = InteractionHandlers[(uint8)Type])
+		(this->*Handler)(OtherActor);
+}
+
+void ACollectCharacter::CollectRecharge(AActor* Recharge)
+{
+	// Only the server collects, the clients get the new health through the player state
+	if (!HasAuthority() || !CollectState || !RoundState->IsPlaying())
+		return;
+
+	// More health moves the time of death and the next change of the display
+	CollectState->AddHealth(10.0f, 100.0f);
+
+	// Return pooled recharges to the pool, destroy the others
+	UPickupPoolSubsystem* PickupPool = GetWorld()->GetSubsystem<UPickupPoolSubsystem>();
+
+	if (!PickupPool || !PickupPool->Release(Recharge))
+		Recharge->Destroy();
+
+	MulticastRechargeCollected(GetActorLocation());
+}
+
+void ACollectCharacter::MulticastRechargeCollected_Implementation(FVector Location)
+{
+	// Play the particle and sound
+	if (GetNetMode() != NM_DedicatedServer)
+		FeedbackEffects->Play(PickingUpHealthEffect.Get(), PickingUpHealthSound, Location);
+}
+
+#pragma endregion
+
+#pragma region Handlers
+
+void ACollectCharacter::SyncHealth()
+{
+	// Derived from the replicated values and the server clock, so every machine shows the same
+	if (!CollectState)
+		return;
+
+	Health = CollectState->GetHealth();
+	timer = CollectState->GetTimeRemaining();
+}
+
+void ACollectCharacter::ScheduleRoundEnd()
+{
+	if (!CollectState || !CollectState->HasRoundStarted())
+		return;
+
+	const float TimeLeft = CollectState->GetTimeRemaining();
+	const float TimeToDeath = CollectState->GetTimeToDeath();
+
+	// Only the first of the two can happen
+	if (TimeToDeath >= TimeLeft)
+		RoundState->ScheduleOutcome(ERoundState::Won, TimeLeft);
+	else if (HasAuthority())
+		RoundState->ScheduleOutcome(ERoundState::Lost, TimeToDeath);
+	else
+	{
+		// The server decides a death, a recharge it collected may not have arrived here yet
+		RoundState->ClearScheduledOutcome();
+	}
+}
+
+void ACollectCharacter::StartRound()
+{
+	// The round ends when the countdown runs out or when the health is gone
+	if (HasAuthority() && CollectState)
+		CollectState->StartRound(StartHealth, RoundDuration, HealthDecreaseAmount);
+}
+
+void ACollectCharacter::BindPlayerState()
+{
+	ACollectPlayerState* NewState = GetPlayerState<ACollectPlayerState>();
+
+	if (NewState == CollectState)
+		return;
+
+	if (CollectState)
+		CollectState->OnStateChanged.RemoveAll(this);
+
+	CollectState = NewState;
+
+	if (!CollectState)
+	{
+		if (GetPlayerState())
+			UE_LOG(LogTheLab, Warning, TEXT("%s needs a CollectPlayerState to play the round"), *GetName());
+
+		return;
+	}
+
+	CollectState->OnStateChanged.AddUObject(this, &ACollectCharacter::OnCollectStateChanged);
+
+	// The server starts the round once the character began play, the clients take what is replicated
+	if (HasAuthority() && !CollectState->HasRoundStarted())
+	{
+		if (HasActorBegunPlay() || IsActorBeginningPlay())
+			StartRound();
+	}
+	else
+		OnCollectStateChanged();
+}
+
+void ACollectCharacter::OnCollectStateChanged()
+{
+	if (!CollectState->HasRoundStarted())
+		return;
+
+	// The server started the next round after this one ended
+	if (CollectState->GetRoundNumber() != PlayedRound)
+	{
+		PlayedRound = CollectState->GetRoundNumber();
+
+		if (!RoundState->IsPlaying())
+			BeginNextRound();
+	}
+
+	if (!RoundState->IsPlaying())
+		return;
+
+	if (CollectState->IsDead())
+	{
+		RoundState->FinishRound(ERoundState::Lost);
+		return;
+	}
+
+	ScheduleRoundEnd();
+	RefreshDisplay();
+}
+
+void ACollectCharacter::RefreshDisplay()
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_RefreshDisplay);
+
+	SyncHealth();
+
+	// Nobody looks at the values of the characters of other players
+	if (!IsLocalView())
+		return;
+
+	HUDData->SetHealth(Health);
+	HUDData->SetTimeRemaining(timer);
+
+	// Refresh again when the first of the displayed second or health changes
+	if (RoundState->IsPlaying())
+	{
+		const float Delay = FMath::Min(UHUDDataComponent::GetSecondsUntilDisplayChange(timer, 1.0f), UHUDDataComponent::GetSecondsUntilDisplayChange(Health, HealthDecreaseAmount));
+		GetWorldTimerManager().SetTimer(DisplayTimerHandle, this, &ACollectCharacter::RefreshDisplay, Delay + DisplayRefreshMargin, false);
+	}
+}
+
+void ACollectCharacter::OnRoundStateChanged(ERoundState OldState, ERoundState NewState)
+{
+	if (NewState == ERoundState::Won)
+	{
+		GetWorldTimerManager().ClearTimer(DisplayTimerHandle);
+		SyncHealth();
+		timer = 0;
+
+		HUDData->SetHealth(Health);
+		HUDData->SetTimeRemaining(timer);
+
+		// Loads the class now when its preload hasn't finished yet
+		if (IsLocalView() && HUDWidgets)
+			Player_Won_Widget = HUDWidgets->Show(Player_Won_Widget_Class.LoadSynchronous());
+
+		// The server ends the round of every player, the owning client only fades its screen
+		if (HasAuthority() || IsLocalView())
+			GetWorldTimerManager().SetTimer(RoundEndTimerHandle, this, &ACollectCharacter::CallFadeOut_Won, RoundEndDelay, false);
+	}
+	else if (NewState == ERoundState::Lost)
+	{
+		GetWorldTimerManager().ClearTimer(DisplayTimerHandle);
+		RefreshDisplay();
+		Health = 0;
+		HUDData->SetHealth(Health);
+
+		pDead = true;
+		GetMesh()->SetSimulatePhysics(true);
+
+		// Tell the clients, they don't schedule a death themselves
+		if (HasAuthority() && CollectState)
+			CollectState->SetDead(true);
+
+		if (IsLocalView() && HUDWidgets)
+			Player_Lost_Widget = HUDWidgets->Show(Player_Lost_Widget_Class.LoadSynchronous());
+
+		if (HasAuthority() || IsLocalView())
+			GetWorldTimerManager().SetTimer(RoundEndTimerHandle, this, &ACollectCharacter::CallFadeOut_Lost, RoundEndDelay, false);
+	}
+}
+
+void ACollectCharacter::BeginNextRound()
+{
+	GetWorldTimerManager().ClearTimer(RoundEndTimerHandle);
+	GetWorldTimerManager().ClearTimer(DisplayTimerHandle);
+
+	// The server already put the whole player back, a client only takes its copy out of the ragdoll
+	if (!HasAuthority())
+		RoundReset->RestorePlayerMesh(this);
+
+	pDead = false;
+	GetCharacterMovement()->MaxWalkSpeed = pMaxWalkSpeed;
+
+	// UI
+	if (IsLocalView())
+	{
+		if (HUDWidgets)
+		{
+			HUDWidgets->Hide(Player_Won_Widget_Class.Get());
+			HUDWidgets->Hide(Player_Lost_Widget_Class.Get());
+		}
+
+		GetWorld()->GetSubsystem<UScreenFadeSubsystem>()->FadeIn();
+	}
+
+	RoundState->ResetRound();
+}
+
+bool ACollectCharacter::IsLocalView() const
+{
+	return GetNetMode() == NM_Standalone || IsLocallyControlled();
+}
+
+void ACollectCharacter::SetupLocalView()
+{
+	if (bLocalViewSetUp || !IsLocalView())
+		return;
+
+	bLocalViewSetUp = true;
+
+	// Load the UI in the background, the HUD is needed right away and the end of round UI only in a while
+	HUDWidgets = UHUDWidgetSubsystem::Get(this);
+
+	if (HUDWidgets)
+	{
+		UAssetPreloadSubsystem* AssetPreload = UAssetPreloadSubsystem::Get(this);
+
+		HUDAssets = AssetPreload->Preload({ Player_Health_Widget_Class.ToSoftObjectPath() }, FOnAssetsPreloaded::CreateUObject(this, &ACollectCharacter::OnHUDAssetsLoaded), true);
+		RoundEndAssets = AssetPreload->Preload({ Player_Won_Widget_Class.ToSoftObjectPath(), Player_Lost_Widget_Class.ToSoftObjectPath() }, FOnAssetsPreloaded::CreateUObject(this, &ACollectCharacter::OnRoundEndAssetsLoaded));
+	}
+
+	// Read the saved progress
+	if (UProgressSaveSubsystem* ProgressSave = UProgressSaveSubsystem::Get(this))
+	{
+		level1Won |= ProgressSave->IsGameWon("Game1");
+		level2Won |= ProgressSave->IsGameWon("Game2");
+	}
+
+	// The values may have arrived before the character knew it was the local one
+	if (CollectState)
+		RefreshDisplay();
+}
+
+void ACollectCharacter::OnPickupAssetsLoaded()
+{
+	FeedbackEffects->Prewarm(PickingUpHealthEffect.Get(), PickingUpHealthSound);
+}
+
+void ACollectCharacter::OnHUDAssetsLoaded()
+{
+	// The widget shows the values that were set while it was loading
+	Player_Health_Widget = HUDWidgets->Show(Player_Health_Widget_Class.Get());
+
+	if (UPlayerHUDWidget* HUDWidget = Cast<UPlayerHUDWidget>(Player_Health_Widget))
+		HUDWidget->SetDataSource(HUDData);
+	else if (Player_Health_Widget)
+		UE_LOG(LogTheLab, Warning, TEXT("%s isn't a PlayerHUDWidget, its property bindings poll every frame (reparent it to PlayerHUDWidget)"), *Player_Health_Widget->GetClass()->GetName());
+}
+
+void ACollectCharacter::OnRoundEndAssetsLoaded()
+{
+	// Build the end of round UI up front so it only has to be shown
+	HUDWidgets->Prewarm(Player_Won_Widget_Class.Get());
+	HUDWidgets->Prewarm(Player_Lost_Widget_Class.Get());
+}
+
+#pragma endregion
+
+#pragma region Callers / Level Switchers / Data Savers
+
+void ACollectCharacter::CallFadeOut_Won()
+{
+	RoundState->BeginTransition();
+
+	// Every player saves their own progress
+	if (IsLocalView())
+	{
+		level1Won = true;
+		CallSaveGameVariables();
+	}
+
+	FadeOutToTransition(&ACollectCharacter::ToMainLevel);
+}
+
+void ACollectCharacter::CallFadeOut_Lost()
+{
+	RoundState->BeginTransition();
+
+	FadeOutToTransition(&ACollectCharacter::RestartGame);
+}
+
+void ACollectCharacter::FadeOutToTransition(FRoundTransition Transition)
+{
+	// Only the server restarts the round or changes the level, a client follows what it replicates
+	FOnFadeFinished OnFaded;
+
+	if (HasAuthority())
+		OnFaded.BindUObject(this, Transition);
+
+	// The screen of a remote player fades on its own machine, the server waits as long as that takes
+	const float FadeDuration = UScreenFadeSubsystem::GetDefaultDuration();
+
+	if (IsLocalView())
+		GetWorld()->GetSubsystem<UScreenFadeSubsystem>()->FadeOut(OnFaded);
+	else if (FadeDuration > 0.0f)
+		GetWorldTimerManager().SetTimer(RoundEndTimerHandle, this, Transition, FadeDuration, false);
+	else
+		(this->*Transition)();
+}
+
+bool ACollectCharacter::IsAnotherPlayerInRound() const
+{
+	for (TActorIterator<ACollectCharacter> It(GetWorld()); It; ++It)
+	{
+		if (*It != this && It->RoundState->IsPlaying())
+			return true;
+	}
+
+	return false;
+}
+
+void ACollectCharacter::ToMainLevel()
+{
+	GetWorld()->GetSubsystem<ULevelTransitionSubsystem>()->ReturnToHub(true);
+}
+
+void ACollectCharacter::RestartGame()
+{
+	// In a networked game reloading the map is a server travel, it restarts the round of every player
+	if (URoundResetSubsystem::IsInPlaceRestartEnabled() && RoundReset->HasSnapshot(this))
+		ResetRound();
+	else
+		GetWorld()->GetSubsystem<ULevelTransitionSubsystem>()->RestartGame();
+}
+
+void ACollectCharacter::ResetRound()
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_RoundReset);
+
+	// The pickups are shared by the players of the level, they only go back when nobody else is in a round
+	if (!IsAnotherPlayerInRound())
+		RoundReset->RestorePickups();
+
+	// Transform and ragdoll
+	RoundReset->RestorePlayer(this);
+
+	// The new round replicates, and every machine puts the character back in it (see BeginNextRound)
+	StartRound();
+}
+
+void ACollectCharacter::CallSaveGameVariables()
+{
+	UProgressSaveSubsystem* ProgressSave = UProgressSaveSubsystem::Get(this);
+
+	if (!ProgressSave)
+		return;
+
+	if (level1Won)
+		ProgressSave->MarkGameWon("Game1");
+	if (level2Won)
+		ProgressSave->MarkGameWon("Game2");
+
+	ProgressSave->SaveAsync();
+}
+
+#pragma endregion
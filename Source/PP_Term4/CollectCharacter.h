@@ -1,151 +1,262 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "GameFramework/Character.h"
-
-#include "Camera/CameraComponent.h"
-
-#include "Components/CapsuleComponent.h"
-#include "Components/StaticMeshComponent.h"
-#include "Components/InputComponent.h"
-#include "Components/SphereComponent.h"
-
-#include "Animation/SkeletalMeshActor.h"
-
-#include "Runtime/Engine/Classes/Kismet/GameplayStatics.h"
-#include "Runtime/Engine/Classes/Kismet/KismetSystemLibrary.h"
-
-#include "GameFramework/CharacterMovementComponent.h"
-#include "GameFramework/Controller.h"
-#include "GameFramework/SpringArmComponent.h"
-
-#include "Blueprint/UserWidget.h"
-
-#include "Misc/OutputDeviceNull.h"
-
-#include "CollectCharacter.generated.h"
-
-UCLASS()
-class PP_TERM4_API ACollectCharacter : public ACharacter
-{
-	GENERATED_BODY()
-
-public:
-	// Sets default values for this character's properties
-	ACollectCharacter();
-
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-
-public:
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
-	// Called to bind functionality to input
-	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
-
-public:
-	// Camera
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
-		USpringArmComponent* CameraBoom;
-
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
-		UCameraComponent* FollowCamera;
-
-
-	// Movement
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Walking")
-		float pMaxWalkSpeed;
-
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Character Movement: Walking")
-		float SprintSpeedMultiplier;
-
-
-	// Winning states
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-		bool level1Won;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-		bool level2Won;
-
-
-	// Health variables
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
-		float Health;
-
-	UPROPERTY(EditAnywhere)
-		float HealthDecreaseAmount;
-
-
-	// Timer
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Timer")
-		float timer = 30.0f;
-
-
-	// UI references	
-	UPROPERTY(EditAnyWhere, Category = "UI HUD")
-		TSubclassOf<UUserWidget> Player_Health_Widget_Class;
-	UUserWidget* Player_Health_Widget;
-
-	UPROPERTY(EditAnyWhere, Category = "UI HUD")
-		TSubclassOf<UUserWidget> Player_Won_Widget_Class;
-	UUserWidget* Player_Won_Widget;
-
-	UPROPERTY(EditAnyWhere, Category = "UI HUD")
-		TSubclassOf<UUserWidget> Player_Lost_Widget_Class;
-	UUserWidget* Player_Lost_Widget;
-
-
-	// Particle reference
-	UPROPERTY(EditAnyWhere, Category = "Particles")
-		UParticleSystem* PickingUpHealthEffect;
-
-
-	// Blueprint reference
-	UPROPERTY(EditAnywhere, Category = "BlueprintClass")
-		AActor* blueprintActor;
-
-private:
-	// Movement
-	void MoveForward(float Axis);
-	void MoveRight(float Axis);
-
-	void MoveCamera(float Axis);
-
-	void Sprint();
-	void StopSprinting();
-
-
-	// Handlers
-	void HandleTimer(float pMinusAmount);
-	void HandleHP(float pDeltaTime);
-
-
-	// Callers / Level Switchers / Data Savers
-	void CallFadeOut_Won();
-	void CallFadeOut_Lost();
-
-	void ToMainLevel();
-	void RestartGame();
-
-	void CallSaveGameVariables();
-
-
-	// Dead
-	bool pDead;
-
-
-	// Overlap
-	UFUNCTION()
-		void OnBeginOverlap(class UPrimitiveComponent* HitComponent,
-			class AActor* OtherActor, class UPrimitiveComponent* OtherComponent,
-			int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
-
-	UFUNCTION()
-		void OnEndOverlap(class UPrimitiveComponent* OverlappedComp,
-			class AActor* OtherActor, class UPrimitiveComponent* OtherComp,
-			int32 OtherBodyIndex);
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Character.h"
+
+#include "Camera/CameraComponent.h"
+
+#include "Components/CapsuleComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/InputComponent.h"
+#include "Components/SphereComponent.h"
+
+#include "Animation/SkeletalMeshActor.h"
+
+#include "Runtime/Engine/Classes/Kismet/GameplayStatics.h"
+#include "Runtime/Engine/Classes/Kismet/KismetSystemLibrary.h"
+
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/SpringArmComponent.h"
+
+#include "Blueprint/UserWidget.h"
+
+#include "AssetPreloadSubsystem.h"
+#include "CollectPlayerState.h"
+#include "HUDDataComponent.h"
+#include "HUDWidgetSubsystem.h"
+#include "InputReplaySubsystem.h"
+#include "FeedbackEffectsSubsystem.h"
+#include "InteractionSubsystem.h"
+#include "LevelTransitionSubsystem.h"
+#include "MovementInputAccumulator.h"
+#include "ProgressSaveSubsystem.h"
+#include "PickupRegistrySubsystem.h"
+#include "PlayerHUDWidget.h"
+#include "RoundResetSubsystem.h"
+#include "RoundStateComponent.h"
+#include "ScreenFadeSubsystem.h"
+
+#include "CollectCharacter.generated.h"
+
+UCLASS()
+class PP_TERM4_API ACollectCharacter : public ACharacter
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this character's properties
+	ACollectCharacter();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Called when the character is destroyed or its level is unloaded
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// The player state holds the round, it arrives with the possession on the server and by replication on the clients
+	virtual void PossessedBy(AController* NewController) override;
+	virtual void OnRep_PlayerState() override;
+	virtual void NotifyControllerChanged() override;
+
+public:
+	// Called to bind functionality to input
+	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
+
+public:
+	// Camera
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
+		USpringArmComponent* CameraBoom;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
+		UCameraComponent* FollowCamera;
+
+
+	// Round
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Round")
+		URoundStateComponent* RoundState;
+
+	// Values shown by the HUD
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "UI HUD")
+		UHUDDataComponent* HUDData;
+
+
+	// Movement
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Walking")
+		float pMaxWalkSpeed;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Character Movement: Walking")
+		float SprintSpeedMultiplier;
+
+
+	// Winning states
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		bool level1Won;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		bool level2Won;
+
+
+	// Health variables
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+		float Health;
+
+	UPROPERTY(EditAnywhere)
+		float HealthDecreaseAmount;
+
+
+	// Timer
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Timer")
+		float timer = 30.0f;
+
+	// UI references (soft, they are loaded in the background after BeginPlay)
+	UPROPERTY(EditAnyWhere, Category = "UI HUD")
+		TSoftClassPtr<UUserWidget> Player_Health_Widget_Class;
+	UUserWidget* Player_Health_Widget;
+
+	UPROPERTY(EditAnyWhere, Category = "UI HUD")
+		TSoftClassPtr<UUserWidget> Player_Won_Widget_Class;
+	UUserWidget* Player_Won_Widget;
+
+	UPROPERTY(EditAnyWhere, Category = "UI HUD")
+		TSoftClassPtr<UUserWidget> Player_Lost_Widget_Class;
+	UUserWidget* Player_Lost_Widget;
+
+
+	// Particle reference (soft, like the UI)
+	UPROPERTY(EditAnyWhere, Category = "Particles")
+		TSoftObjectPtr<UParticleSystem> PickingUpHealthEffect;
+
+	// Sound reference
+	UPROPERTY(EditAnyWhere, Category = "Particles")
+		USoundBase* PickingUpHealthSound;
+
+private:
+	// Movement
+	void MoveForward(float Axis);
+	void MoveRight(float Axis);
+
+	FMovementInputAccumulator MovementInput;
+
+	void MoveCamera(float Axis);
+
+	void Sprint();
+	void StopSprinting();
+
+
+	// Handlers
+	void SyncHealth();
+	void ScheduleRoundEnd();
+
+	void StartRound();
+	void RefreshDisplay();
+	void OnRoundStateChanged(ERoundState OldState, ERoundState NewState);
+
+	// Puts the character back in the round the server started again (on every machine)
+	void BeginNextRound();
+
+	FTimerHandle DisplayTimerHandle;
+	FTimerHandle RoundEndTimerHandle;
+
+	// Seconds the won or lost screen is shown before the fade
+	static constexpr float RoundEndDelay = 3.0f;
+
+	// Keeps the refresh just past the change so the rounding lands on the new value
+	static constexpr float DisplayRefreshMargin = 0.01f;
+
+
+	// Replicated health and countdown
+	void BindPlayerState();
+	void OnCollectStateChanged();
+
+	ACollectPlayerState* CollectState;
+
+	// Round of the player state the character is in
+	int32 PlayedRound;
+
+
+	// UI, fades and level changes only happen for the player that controls this character
+	bool IsLocalView() const;
+	void SetupLocalView();
+
+	bool bLocalViewSetUp;
+
+	// Values the round starts with
+	float StartHealth;
+	float RoundDuration;
+
+
+	// Callers / Level Switchers / Data Savers
+	void CallFadeOut_Won();
+	void CallFadeOut_Lost();
+
+	// Fades the screen of the player, and the server moves on to the transition once the fade is done
+	typedef void (ACollectCharacter::*FRoundTransition)();
+	void FadeOutToTransition(FRoundTransition Transition);
+
+	// Whether the round of another player in the level is still running
+	bool IsAnotherPlayerInRound() const;
+
+	void ToMainLevel();
+	void RestartGame();
+
+	// Restores the start of the round in place
+	void ResetRound();
+
+	void CallSaveGameVariables();
+
+
+	// Dead
+	bool pDead;
+
+
+	// Interactions
+	typedef void (ACollectCharacter::*FInteractionHandler)(AActor*);
+	static const FInteractionHandler InteractionHandlers[];
+
+	UInteractionSubsystem* InteractionSubsystem;
+
+
+	// UI pool of the local player
+	UHUDWidgetSubsystem* HUDWidgets;
+
+
+	// Pickup particles and sounds
+	UFeedbackEffectsSubsystem* FeedbackEffects;
+
+
+	// Soft referenced assets, kept loaded while the handles are held
+	void OnPickupAssetsLoaded();
+	void OnHUDAssetsLoaded();
+	void OnRoundEndAssetsLoaded();
+
+	TSharedPtr<FStreamableHandle> PickupAssets;
+	TSharedPtr<FStreamableHandle> HUDAssets;
+	TSharedPtr<FStreamableHandle> RoundEndAssets;
+
+
+	// Snapshot of the start of the round
+	URoundResetSubsystem* RoundReset;
+
+	void Interact(AActor* OtherActor, EInteractionType Type);
+	void CollectRecharge(AActor* Recharge);
+
+	// Plays the pickup effects on every machine after the server collected a recharge
+	UFUNCTION(NetMulticast, Unreliable)
+		void MulticastRechargeCollected(FVector Location);
+
+
+	// Overlap
+	UFUNCTION()
+		void OnBeginOverlap(class UPrimitiveComponent* HitComponent,
+			class AActor* OtherActor, class UPrimitiveComponent* OtherComponent,
+			int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	UFUNCTION()
+		void OnEndOverlap(class UPrimitiveComponent* OverlappedComp,
+			class AActor* OtherActor, class UPrimitiveComponent* OtherComp,
+			int32 OtherBodyIndex);
+};
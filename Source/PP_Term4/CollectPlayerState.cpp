@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CollectPlayerState.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Net/UnrealNetwork.h"
+
+ACollectPlayerState::ACollectPlayerState()
+{
+	SyncedHealth = 0.0f;
+	HealthSyncTime = 0.0f;
+	RoundEndTime = 0.0f;
+	HealthDecreaseAmount = 0.0f;
+	bDead = false;
+	RoundNumber = 0;
+}
+
+void ACollectPlayerState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Only compared when marked dirty
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(ACollectPlayerState, SyncedHealth, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ACollectPlayerState, HealthSyncTime, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ACollectPlayerState, RoundEndTime, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ACollectPlayerState, HealthDecreaseAmount, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ACollectPlayerState, bDead, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ACollectPlayerState, RoundNumber, Params);
+}
+
+void ACollectPlayerState::StartRound(float StartHealth, float Duration, float InHealthDecreaseAmount)
+{
+	if (!HasAuthority())
+		return;
+
+	const float Now = GetServerTime();
+
+	SyncedHealth = StartHealth;
+	HealthSyncTime = Now;
+	RoundEndTime = Now + Duration;
+	HealthDecreaseAmount = InHealthDecreaseAmount;
+	bDead = false;
+	RoundNumber++;
+
+	MARK_PROPERTY_DIRTY_FROM_NAME(ACollectPlayerState, SyncedHealth, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(ACollectPlayerState, HealthSyncTime, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(ACollectPlayerState, RoundEndTime, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(ACollectPlayerState, HealthDecreaseAmount, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(ACollectPlayerState, bDead, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(ACollectPlayerState, RoundNumber, this);
+
+	// Player states replicate rarely by default, the round shouldn't wait for that
+	ForceNetUpdate();
+	OnStateChanged.Broadcast();
+}
+
+void ACollectPlayerState::AddHealth(float Amount, float MaxHealth)
+{
+	if (!HasAuthority() || bDead)
+		return;
+
+	const float NewHealth = FMath::Min(GetHealth() + Amount, MaxHealth);
+
+	// The drain doesn't need replicating, only a new starting point does
+	SyncedHealth = NewHealth;
+	HealthSyncTime = GetServerTime();
+
+	MARK_PROPERTY_DIRTY_FROM_NAME(ACollectPlayerState, SyncedHealth, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(ACollectPlayerState, HealthSyncTime, this);
+
+	ForceNetUpdate();
+	OnStateChanged.Broadcast();
+}
+
+void ACollectPlayerState::SetDead(bool bInDead)
+{
+	if (!HasAuthority() || bDead == bInDead)
+		return;
+
+	bDead = bInDead;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ACollectPlayerState, bDead, this);
+
+	ForceNetUpdate();
+	OnStateChanged.Broadcast();
+}
+
+float ACollectPlayerState::GetHealth() const
+{
+	if (bDead)
+		return 0.0f;
+
+	return FMath::Max(SyncedHealth - (GetServerTime() - HealthSyncTime) * HealthDecreaseAmount, 0.0f);
+}
+
+float ACollectPlayerState::GetTimeRemaining() const
+{
+	return FMath::Max(RoundEndTime - GetServerTime(), 0.0f);
+}
+
+float ACollectPlayerState::GetTimeToDeath() const
+{
+	return HealthDecreaseAmount > 0.0f ? GetHealth() / HealthDecreaseAmount : TNumericLimits<float>::Max();
+}
+
+float ACollectPlayerState::GetServerTime() const
+{
+	// Synchronized with the server on clients
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+
+	return GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+}
+
+void ACollectPlayerState::OnRep_State()
+{
+	OnStateChanged.Broadcast();
+}
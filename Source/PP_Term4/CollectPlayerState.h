@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/PlayerState.h"
+
+#include "CollectPlayerState.generated.h"
+
+DECLARE_MULTICAST_DELEGATE(FOnCollectStateChanged);
+
+/**
+ * Health and countdown of a player in the Collect game, owned by the server and replicated with the push model.
+ * Nothing changes per tick: health is replicated as a value at a server time and drains from there,
+ * and the countdown is replicated as the server time it ends. Every machine derives the current values from the
+ * synchronized server clock, and a property is only marked dirty when it actually changes.
+ */
+UCLASS()
+class PP_TERM4_API ACollectPlayerState : public APlayerState
+{
+	GENERATED_BODY()
+
+public:
+	ACollectPlayerState();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Server: starts a round with full health and the countdown
+	void StartRound(float StartHealth, float Duration, float InHealthDecreaseAmount);
+
+	// Server: adds health (capped at MaxHealth), moving the time of death
+	void AddHealth(float Amount, float MaxHealth);
+
+	// Server
+	void SetDead(bool bInDead);
+
+	// Current values, on the server and the clients
+	float GetHealth() const;
+	float GetTimeRemaining() const;
+	float GetTimeToDeath() const;
+
+	bool IsDead() const { return bDead; }
+	bool HasRoundStarted() const { return RoundEndTime > 0.0f; }
+
+	// Counts the rounds the server started, a new number means the player is playing again
+	int32 GetRoundNumber() const { return RoundNumber; }
+
+	// Called on every machine when a replicated value changed
+	FOnCollectStateChanged OnStateChanged;
+
+private:
+	float GetServerTime() const;
+
+	UFUNCTION()
+		void OnRep_State();
+
+	// Health at HealthSyncTime
+	UPROPERTY(ReplicatedUsing = OnRep_State)
+		float SyncedHealth;
+
+	UPROPERTY(ReplicatedUsing = OnRep_State)
+		float HealthSyncTime;
+
+	// Server time at which the countdown ends
+	UPROPERTY(ReplicatedUsing = OnRep_State)
+		float RoundEndTime;
+
+	// Health lost per second
+	UPROPERTY(ReplicatedUsing = OnRep_State)
+		float HealthDecreaseAmount;
+
+	UPROPERTY(ReplicatedUsing = OnRep_State)
+		bool bDead;
+
+	UPROPERTY(ReplicatedUsing = OnRep_State)
+		int32 RoundNumber;
+};
@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FeedbackEffectsSubsystem.h"
+#include "PP_Term4.h"
+#include "TheLabStats.h"
+#include "Components/AudioComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "Particles/ParticleSystem.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "Sound/SoundBase.h"
+
+static TAutoConsoleVariable<int32> CVarFeedbackRingSize(
+	TEXT("thelab.Feedback.RingSize"),
+	4,
+	TEXT("Amount of components that play the same pickup effect (the oldest one is restarted when all are used)."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarFeedbackMaxPerFrame(
+	TEXT("thelab.Feedback.MaxPerFrame"),
+	4,
+	TEXT("Maximum amount of pickup effects that can start in one frame (0 = no limit)."),
+	ECVF_Default);
+
+// Console command to print the counters of the effects in the current world
+static FAutoConsoleCommandWithWorld GFeedbackStatsCommand(
+	TEXT("thelab.Feedback.Stats"),
+	TEXT("Logs the counters of the pickup feedback effects in the current world."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UFeedbackEffectsSubsystem* FeedbackEffects = World ? World->GetSubsystem<UFeedbackEffectsSubsystem>() : nullptr)
+			FeedbackEffects->LogStats();
+	}));
+
+void UFeedbackEffectsSubsystem::Deinitialize()
+{
+	LogStats();
+
+	for (TPair<UObject*, FFeedbackEffectRing>& Pair : Rings)
+	{
+		for (UParticleSystemComponent* Component : Pair.Value.ParticleComponents)
+		{
+			if (IsValid(Component))
+				Component->DestroyComponent();
+		}
+
+		for (UAudioComponent* Component : Pair.Value.AudioComponents)
+		{
+			if (IsValid(Component))
+				Component->DestroyComponent();
+		}
+	}
+
+	Rings.Empty();
+
+	Super::Deinitialize();
+}
+
+void UFeedbackEffectsSubsystem::Prewarm(UParticleSystem* Particles, USoundBase* Sound)
+{
+	const int32 RingSize = FMath::Max(CVarFeedbackRingSize.GetValueOnGameThread(), 1);
+
+	if (Particles)
+	{
+		FFeedbackEffectRing& Ring = Rings.FindOrAdd(Particles);
+
+		while (Ring.ParticleComponents.Num() < RingSize)
+			Ring.ParticleComponents.Add(CreateParticleComponent(Particles));
+	}
+
+	if (Sound)
+	{
+		FFeedbackEffectRing& Ring = Rings.FindOrAdd(Sound);
+
+		while (Ring.AudioComponents.Num() < RingSize)
+			Ring.AudioComponents.Add(CreateAudioComponent(Sound));
+	}
+}
+
+bool UFeedbackEffectsSubsystem::Play(UParticleSystem* Particles, USoundBase* Sound, const FVector& Location)
+{
+	if (!Particles && !Sound)
+		return false;
+
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_FeedbackEffect);
+
+	// Start a new budget every frame
+	if (BudgetFrame != GFrameCounter)
+	{
+		BudgetFrame = GFrameCounter;
+		PlaysThisFrame = 0;
+	}
+
+	const int32 MaxPerFrame = CVarFeedbackMaxPerFrame.GetValueOnGameThread();
+
+	if (MaxPerFrame > 0 && PlaysThisFrame >= MaxPerFrame)
+	{
+		Dropped++;
+		return false;
+	}
+
+	PlaysThisFrame++;
+
+	const int32 RingSize = FMath::Max(CVarFeedbackRingSize.GetValueOnGameThread(), 1);
+
+	if (Particles)
+	{
+		FFeedbackEffectRing& Ring = Rings.FindOrAdd(Particles);
+
+		// Grow the ring until it is full, then take the oldest component
+		UParticleSystemComponent* Component = nullptr;
+
+		if (Ring.ParticleComponents.Num() < RingSize)
+			Component = Ring.ParticleComponents.Add_GetRef(CreateParticleComponent(Particles));
+		else
+		{
+			Ring.Next %= Ring.ParticleComponents.Num();
+			UParticleSystemComponent*& Oldest = Ring.ParticleComponents[Ring.Next++];
+
+			// Replace components that got destroyed with the level that owned them
+			if (!IsValid(Oldest))
+				Oldest = CreateParticleComponent(Particles);
+			else if (Oldest->IsActive())
+				Ring.Recycled++;
+
+			Component = Oldest;
+		}
+
+		if (Component)
+		{
+			Component->SetWorldLocation(Location);
+			Component->ActivateSystem(true);
+			Ring.Plays++;
+		}
+	}
+
+	if (Sound)
+	{
+		FFeedbackEffectRing& Ring = Rings.FindOrAdd(Sound);
+
+		UAudioComponent* Component = nullptr;
+
+		if (Ring.AudioComponents.Num() < RingSize)
+			Component = Ring.AudioComponents.Add_GetRef(CreateAudioComponent(Sound));
+		else
+		{
+			Ring.Next %= Ring.AudioComponents.Num();
+			UAudioComponent*& Oldest = Ring.AudioComponents[Ring.Next++];
+
+			if (!IsValid(Oldest))
+				Oldest = CreateAudioComponent(Sound);
+			else if (Oldest->IsPlaying())
+				Ring.Recycled++;
+
+			Component = Oldest;
+		}
+
+		if (Component)
+		{
+			Component->SetWorldLocation(Location);
+			Component->Play();
+			Ring.Plays++;
+		}
+	}
+
+	return true;
+}
+
+void UFeedbackEffectsSubsystem::LogStats() const
+{
+	for (const TPair<UObject*, FFeedbackEffectRing>& Pair : Rings)
+	{
+		const FFeedbackEffectRing& Ring = Pair.Value;
+
+		UE_LOG(LogTheLab, Log, TEXT("Feedback effect %s: %d components, %d plays, %d recycled while playing"),
+			*GetNameSafe(Pair.Key), Ring.ParticleComponents.Num() + Ring.AudioComponents.Num(), Ring.Plays, Ring.Recycled);
+	}
+
+	if (Dropped > 0)
+		UE_LOG(LogTheLab, Log, TEXT("Feedback effects: %d plays dropped by the frame budget"), Dropped);
+}
+
+UParticleSystemComponent* UFeedbackEffectsSubsystem::CreateParticleComponent(UParticleSystem* Particles)
+{
+	UWorld* World = GetWorld();
+
+	// Owned by the world settings like the emitters spawned by the gameplay statics
+	UParticleSystemComponent* Component = NewObject<UParticleSystemComponent>(World->GetWorldSettings());
+	Component->bAutoActivate = false;
+	Component->bAutoDestroy = false;
+	Component->SetTemplate(Particles);
+	Component->RegisterComponentWithWorld(World);
+
+	return Component;
+}
+
+UAudioComponent* UFeedbackEffectsSubsystem::CreateAudioComponent(USoundBase* Sound)
+{
+	UWorld* World = GetWorld();
+
+	UAudioComponent* Component = NewObject<UAudioComponent>(World->GetWorldSettings());
+	Component->bAutoActivate = false;
+	Component->bAutoDestroy = false;
+	Component->bAllowSpatialization = true;
+	Component->SetSound(Sound);
+	Component->RegisterComponentWithWorld(World);
+
+	return Component;
+}
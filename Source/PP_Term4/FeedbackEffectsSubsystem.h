@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "FeedbackEffectsSubsystem.generated.h"
+
+class UAudioComponent;
+class UParticleSystem;
+class UParticleSystemComponent;
+class USoundBase;
+
+// Fixed ring of components that play the same particle system or sound
+USTRUCT()
+struct FFeedbackEffectRing
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<UParticleSystemComponent*> ParticleComponents;
+
+	UPROPERTY()
+		TArray<UAudioComponent*> AudioComponents;
+
+	// Index of the component that is played next (the oldest one)
+	int32 Next = 0;
+
+	// Counters
+	int32 Plays = 0;		// Effects that were played
+	int32 Recycled = 0;		// Plays that restarted a component that was still playing
+};
+
+/**
+ * Plays the pickup feedback (particles and sound) on a small ring of components per effect,
+ * instead of creating a new component for every pickup.
+ * When the ring is full the oldest component is restarted, and a per-frame budget limits how many effects can start at once.
+ */
+UCLASS()
+class PP_TERM4_API UFeedbackEffectsSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Creates the components of the effects up front (either may be nullptr)
+	void Prewarm(UParticleSystem* Particles, USoundBase* Sound);
+
+	// Plays the effects at the location (returns false when the budget of this frame is used up)
+	bool Play(UParticleSystem* Particles, USoundBase* Sound, const FVector& Location);
+
+	void LogStats() const;
+
+private:
+	UParticleSystemComponent* CreateParticleComponent(UParticleSystem* Particles);
+	UAudioComponent* CreateAudioComponent(USoundBase* Sound);
+
+	// Rings per particle system or sound
+	UPROPERTY()
+		TMap<UObject*, FFeedbackEffectRing> Rings;
+
+	// Budget of the current frame
+	uint64 BudgetFrame = 0;
+	int32 PlaysThisFrame = 0;
+
+	// Plays that were dropped by the budget
+	int32 Dropped = 0;
+};
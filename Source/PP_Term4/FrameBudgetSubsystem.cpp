@@ -0,0 +1,319 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FrameBudgetSubsystem.h"
+#include "PP_Term4.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "RenderCore.h"
+#include "RHI.h"
+
+static TAutoConsoleVariable<bool> CVarBudgetEnable(
+	TEXT("thelab.Budget.Enable"),
+	true,
+	TEXT("Adapts the screen percentage and scalability to hold the target frame time."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarBudgetTargetMs(
+	TEXT("thelab.Budget.TargetMs"),
+	16.67f,
+	TEXT("Target frame time in milliseconds."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarBudgetDownRatio(
+	TEXT("thelab.Budget.DownRatio"),
+	1.05f,
+	TEXT("Steps the quality down when the average frame time is above target * ratio."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarBudgetUpRatio(
+	TEXT("thelab.Budget.UpRatio"),
+	0.75f,
+	TEXT("Steps the quality up when the average frame time is below target * ratio."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarBudgetWindow(
+	TEXT("thelab.Budget.Window"),
+	60,
+	TEXT("Amount of frames that are averaged before a decision."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarBudgetCooldown(
+	TEXT("thelab.Budget.Cooldown"),
+	2.0f,
+	TEXT("Seconds after a step before the next one."),
+	ECVF_Default);
+
+// Steps from full to lowest quality (screen percentage, quality of the expensive groups)
+struct FFrameBudgetStep
+{
+	float ScreenPercentage;
+	int32 GroupQuality;
+};
+
+static const FFrameBudgetStep BudgetSteps[] =
+{
+	{ 100.0f, 3 },
+	{ 100.0f, 2 },
+	{ 90.0f, 2 },
+	{ 80.0f, 2 },
+	{ 70.0f, 1 },
+	{ 60.0f, 1 },
+	{ 50.0f, 0 }
+};
+
+static const int32 NumBudgetSteps = UE_ARRAY_COUNT(BudgetSteps);
+
+bool UFrameBudgetSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (FParse::Param(FCommandLine::Get(), TEXT("TheLabBudgetTest")))
+		return true;
+
+	// The editor keeps its own settings, and the benchmark has to measure the same quality every run
+	return !GIsEditor && !IsRunningDedicatedServer() && !FParse::Param(FCommandLine::Get(), TEXT("TheLabBenchmark"));
+}
+
+void UFrameBudgetSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PlayerLevels = Scalability::GetQualityLevels();
+	AppliedLevels = PlayerLevels;
+
+	Step = 0;
+	Clock = 0.0;
+	LastChangeTime = 0.0;
+	ResetWindow();
+
+	// Synthetic test mode
+	bTestMode = FParse::Param(FCommandLine::Get(), TEXT("TheLabBudgetTest"));
+	TestIndex = 0;
+	TestTime = 0.0f;
+	TestFrames = 0;
+	TestFramesOverBudget = 0;
+	TestStepChanges = 0;
+
+	if (bTestMode)
+	{
+		FString Profile = TEXT("10:30+10:12+10:45+10:9");
+		FParse::Value(FCommandLine::Get(), TEXT("BudgetTestProfile="), Profile);
+
+		TArray<FString> Phases;
+		Profile.ParseIntoArray(Phases, TEXT("+"));
+
+		for (const FString& Phase : Phases)
+		{
+			FString Seconds, Milliseconds;
+
+			if (Phase.Split(TEXT(":"), &Seconds, &Milliseconds))
+				TestProfile.Emplace(FCString::Atof(*Seconds), FCString::Atof(*Milliseconds));
+		}
+
+		UE_LOG(LogTheLab, Log, TEXT("Frame budget test with %d synthetic load phases"), TestProfile.Num());
+	}
+
+	bInitialized = true;
+}
+
+void UFrameBudgetSubsystem::Deinitialize()
+{
+	// Never leave the lowered settings behind
+	RestorePlayerLevels();
+
+	bInitialized = false;
+
+	Super::Deinitialize();
+}
+
+void UFrameBudgetSubsystem::Tick(float DeltaTime)
+{
+	// Still ticks while lowered after the governor got disabled, to hand the settings back
+	if (!bTestMode && !CVarBudgetEnable.GetValueOnGameThread())
+	{
+		UE_LOG(LogTheLab, Log, TEXT("Frame budget: disabled at step %d, restoring the settings of the player"), Step);
+		RestorePlayerLevels();
+		return;
+	}
+
+	// The test runs on its own clock, the real frames of a null RHI say nothing about the synthetic ones
+	const FFrameSample Sample = bTestMode ? MakeSyntheticFrame() : MeasureFrame();
+	Clock += bTestMode ? GetSyntheticFrameSeconds(Sample) : DeltaTime;
+
+	AddSample(Sample);
+
+	if (bTestMode && TestIndex >= TestProfile.Num())
+	{
+		UE_LOG(LogTheLab, Log, TEXT("Frame budget test finished: %d frames, %.1f%% over budget, %d step changes, final step %d"),
+			TestFrames, TestFrames > 0 ? 100.0f * TestFramesOverBudget / TestFrames : 0.0f, TestStepChanges, Step);
+
+		bTestMode = false;
+		FPlatformMisc::RequestExitWithStatus(false, 0);
+		return;
+	}
+
+	// Decide once the window is full and the last step had time to show
+	const int32 WindowSize = FMath::Max(CVarBudgetWindow.GetValueOnGameThread(), 1);
+
+	if (Window.Num() < WindowSize || Clock - LastChangeTime < CVarBudgetCooldown.GetValueOnGameThread())
+		return;
+
+	const float TargetMs = CVarBudgetTargetMs.GetValueOnGameThread();
+	const float AverageMs = WindowSum.GetBottleneck() / Window.Num();
+
+	if (AverageMs > TargetMs * CVarBudgetDownRatio.GetValueOnGameThread() && Step < NumBudgetSteps - 1)
+		ApplyStep(Step + 1, TEXT("over budget"));
+	else if (AverageMs < TargetMs * CVarBudgetUpRatio.GetValueOnGameThread() && Step > 0)
+		ApplyStep(Step - 1, TEXT("under budget"));
+}
+
+bool UFrameBudgetSubsystem::IsTickable() const
+{
+	return bInitialized && !IsTemplate() && (bTestMode || CVarBudgetEnable.GetValueOnGameThread() || Step != 0);
+}
+
+TStatId UFrameBudgetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFrameBudgetSubsystem, STATGROUP_Tickables);
+}
+
+UFrameBudgetSubsystem::FFrameSample UFrameBudgetSubsystem::MeasureFrame() const
+{
+	// Times of the last finished frame of every thread
+	FFrameSample Sample;
+	Sample.GameThread = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	Sample.RenderThread = FPlatformTime::ToMilliseconds(GRenderThreadTime);
+	Sample.GPU = FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles());
+
+	return Sample;
+}
+
+UFrameBudgetSubsystem::FFrameSample UFrameBudgetSubsystem::MakeSyntheticFrame()
+{
+	if (!TestProfile.IsValidIndex(TestIndex))
+		return FFrameSample();
+
+	const float LoadMs = TestProfile[TestIndex].Value;
+
+	// Simple cost model: the GPU scales with the pixels and the group quality, the game thread stays fixed
+	const FFrameBudgetStep& Current = BudgetSteps[Step];
+	const float PixelScale = FMath::Square(Current.ScreenPercentage / 100.0f);
+	const float GroupScale = 1.0f - 0.08f * (3 - Current.GroupQuality);
+
+	FFrameSample Sample;
+	Sample.GameThread = LoadMs * 0.3f;
+	Sample.RenderThread = LoadMs * 0.5f * GroupScale;
+	Sample.GPU = LoadMs * (0.3f + 0.7f * PixelScale) * GroupScale;
+
+	TestFrames++;
+
+	if (Sample.GetBottleneck() > CVarBudgetTargetMs.GetValueOnGameThread())
+		TestFramesOverBudget++;
+
+	// The phase lasts its seconds of synthetic frames
+	TestTime += GetSyntheticFrameSeconds(Sample);
+
+	if (TestTime >= TestProfile[TestIndex].Key)
+	{
+		TestTime = 0.0f;
+		TestIndex++;
+	}
+
+	return Sample;
+}
+
+void UFrameBudgetSubsystem::AddSample(const FFrameSample& Sample)
+{
+	const int32 WindowSize = FMath::Max(CVarBudgetWindow.GetValueOnGameThread(), 1);
+
+	if (Window.Num() > WindowSize)
+		ResetWindow();
+
+	// Replace the oldest sample once the window is full
+	if (Window.Num() < WindowSize)
+		Window.Add(Sample);
+	else
+	{
+		const FFrameSample& Oldest = Window[WindowNext];
+		WindowSum.GameThread -= Oldest.GameThread;
+		WindowSum.RenderThread -= Oldest.RenderThread;
+		WindowSum.GPU -= Oldest.GPU;
+
+		Window[WindowNext] = Sample;
+		WindowNext = (WindowNext + 1) % WindowSize;
+	}
+
+	WindowSum.GameThread += Sample.GameThread;
+	WindowSum.RenderThread += Sample.RenderThread;
+	WindowSum.GPU += Sample.GPU;
+}
+
+void UFrameBudgetSubsystem::ResetWindow()
+{
+	Window.Reset();
+	WindowNext = 0;
+	WindowSum = FFrameSample();
+}
+
+void UFrameBudgetSubsystem::ApplyStep(int32 NewStep, const TCHAR* Reason)
+{
+	const int32 NumFrames = Window.Num();
+
+	UE_LOG(LogTheLab, Log, TEXT("Frame budget: step %d -> %d (%s), average game %.2f ms, render %.2f ms, GPU %.2f ms over %d frames, target %.2f ms"),
+		Step, NewStep, Reason, WindowSum.GameThread / NumFrames, WindowSum.RenderThread / NumFrames, WindowSum.GPU / NumFrames,
+		NumFrames, CVarBudgetTargetMs.GetValueOnGameThread());
+
+	// The player may have changed the settings since the last step
+	ReadPlayerLevels();
+
+	Step = NewStep;
+	LastChangeTime = Clock;
+	TestStepChanges++;
+
+	// Lower the groups and the screen percentage, but never above the settings of the player
+	const FFrameBudgetStep& NewSettings = BudgetSteps[Step];
+
+	Scalability::FQualityLevels Levels = PlayerLevels;
+	Levels.ResolutionQuality = FMath::Min(PlayerLevels.ResolutionQuality, NewSettings.ScreenPercentage);
+	Levels.ShadowQuality = FMath::Min(PlayerLevels.ShadowQuality, NewSettings.GroupQuality);
+	Levels.GlobalIlluminationQuality = FMath::Min(PlayerLevels.GlobalIlluminationQuality, NewSettings.GroupQuality);
+	Levels.ReflectionQuality = FMath::Min(PlayerLevels.ReflectionQuality, NewSettings.GroupQuality);
+	Levels.PostProcessQuality = FMath::Min(PlayerLevels.PostProcessQuality, NewSettings.GroupQuality);
+	Levels.EffectsQuality = FMath::Min(PlayerLevels.EffectsQuality, NewSettings.GroupQuality);
+
+	Scalability::SetQualityLevels(Levels);
+	AppliedLevels = Scalability::GetQualityLevels();
+
+	// The samples of the old settings don't say anything about the new ones
+	ResetWindow();
+}
+
+void UFrameBudgetSubsystem::RestorePlayerLevels()
+{
+	if (Step == 0)
+		return;
+
+	ReadPlayerLevels();
+	Scalability::SetQualityLevels(PlayerLevels);
+	AppliedLevels = Scalability::GetQualityLevels();
+
+	Step = 0;
+	LastChangeTime = Clock;
+	ResetWindow();
+}
+
+void UFrameBudgetSubsystem::ReadPlayerLevels()
+{
+	const Scalability::FQualityLevels CurrentLevels = Scalability::GetQualityLevels();
+
+	// At full quality the current settings are the ones of the player, a lowered step only keeps them when nobody changed them
+	if (Step == 0 || CurrentLevels != AppliedLevels)
+	{
+		if (Step != 0)
+			UE_LOG(LogTheLab, Log, TEXT("Frame budget: the scalability was changed while lowered, taking it as the settings of the player"));
+
+		PlayerLevels = CurrentLevels;
+		AppliedLevels = CurrentLevels;
+	}
+}
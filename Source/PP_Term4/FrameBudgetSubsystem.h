@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tickable.h"
+#include "Scalability.h"
+
+#include "FrameBudgetSubsystem.generated.h"
+
+/**
+ * Holds a target frame time by stepping the screen percentage and the expensive scalability groups
+ * (shadows, global illumination, reflections, post process, effects) down and up at runtime.
+ * The slowest of the game thread, render thread and GPU time is averaged over a sliding window. A step down needs the
+ * average above the target, a step up needs it well below the target, and every step empties the window and waits a
+ * cooldown, so the governor doesn't oscillate. Every decision is logged.
+ *
+ * Tuned with thelab.Budget.* console variables. Not created in the editor or during the benchmark.
+ *
+ * UnrealEditor PP_Term4 -game -nullrhi -unattended -TheLabBudgetTest
+ *   -BudgetTestProfile=10:30+10:12+10:45+10:9    Seconds:milliseconds of synthetic load at full quality
+ * feeds synthetic frame times through the governor instead of measured ones and exits when the profile ends. The test
+ * clock advances by the synthetic frame times, so a phase lasts as long as its frames would at the current step.
+ */
+UCLASS()
+class PP_TERM4_API UFrameBudgetSubsystem : public UGameInstanceSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+
+	int32 GetStep() const { return Step; }
+
+private:
+	// Frame times of one frame in milliseconds
+	struct FFrameSample
+	{
+		float GameThread = 0.0f;
+		float RenderThread = 0.0f;
+		float GPU = 0.0f;
+
+		float GetBottleneck() const { return FMath::Max3(GameThread, RenderThread, GPU); }
+	};
+
+	FFrameSample MeasureFrame() const;
+	FFrameSample MakeSyntheticFrame();
+
+	// Duration of a synthetic frame, at least a millisecond so an idle phase of the test ends too
+	static float GetSyntheticFrameSeconds(const FFrameSample& Sample) { return FMath::Max(Sample.GetBottleneck(), 1.0f) / 1000.0f; }
+
+	void AddSample(const FFrameSample& Sample);
+	void ResetWindow();
+
+	// Moves to the step and applies its scalability
+	void ApplyStep(int32 NewStep, const TCHAR* Reason);
+
+	// Goes back to the scalability of the player when lowered
+	void RestorePlayerLevels();
+
+	// Takes the scalability of the player when it isn't lowered, or when the player changed it since the last step
+	void ReadPlayerLevels();
+
+	// Scalability of the player, the steps never go above it
+	Scalability::FQualityLevels PlayerLevels;
+
+	// Scalability the last step applied
+	Scalability::FQualityLevels AppliedLevels;
+
+	// Only the instance ticks, not the class default object
+	bool bInitialized = false;
+
+	int32 Step;
+
+	// Seconds the governor ticked, and the time of the last step
+	double Clock;
+	double LastChangeTime;
+
+	// Sliding window of samples and their sums
+	TArray<FFrameSample> Window;
+	int32 WindowNext;
+	FFrameSample WindowSum;
+
+	// Synthetic test mode
+	bool bTestMode;
+	TArray<TPair<float, float>> TestProfile;	// Seconds, load in milliseconds at full quality
+	int32 TestIndex;
+	float TestTime;
+	int32 TestFrames;
+	int32 TestFramesOverBudget;
+	int32 TestStepChanges;
+};
@@ -0,0 +1,330 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GhostRaceSubsystem.h"
+#include "PP_Term4.h"
+#include "GhostRacer.h"
+#include "InputReplaySubsystem.h"
+#include "TheLabStats.h"
+#include "Async/Async.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "TimerManager.h"
+
+static TAutoConsoleVariable<bool> CVarGhostEnable(
+	TEXT("thelab.Ghost.Enable"),
+	true,
+	TEXT("Races the player against a ghost of their best run, in the maze of that run."));
+
+static TAutoConsoleVariable<float> CVarGhostMaxSeconds(
+	TEXT("thelab.Ghost.MaxSeconds"),
+	600.0f,
+	TEXT("Longest run that is recorded (in seconds), longer runs can't become the best run."));
+
+static TAutoConsoleVariable<int32> CVarGhostMaxGhosts(
+	TEXT("thelab.Ghost.MaxGhosts"),
+	16,
+	TEXT("Most ghosts in a level at the same time."));
+
+// Console commands to spawn ghosts and print the recording and playback costs
+static FAutoConsoleCommandWithWorldAndArgs GGhostSpawnCommand(
+	TEXT("thelab.Ghost.Spawn"),
+	TEXT("Spawns ghosts of the best run of the level that start one after the other. Usage: thelab.Ghost.Spawn [Count] [Interval]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UGhostRaceSubsystem* GhostRace = UGhostRaceSubsystem::Get(World))
+			GhostRace->SpawnGhosts(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 16, Args.Num() > 1 ? FCString::Atof(*Args[1]) : 0.5f);
+	}));
+
+static FAutoConsoleCommandWithWorld GGhostStatsCommand(
+	TEXT("thelab.Ghost.Stats"),
+	TEXT("Logs the memory of the recorded runs and the playback time of the ghosts since the last call."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UGhostRaceSubsystem* GhostRace = UGhostRaceSubsystem::Get(World))
+			GhostRace->LogStats();
+	}));
+
+void UGhostRaceSubsystem::Deinitialize()
+{
+	// Finish writing the best run before the game closes
+	if (SaveTask.IsValid())
+		SaveTask.Wait();
+
+	BestRuns.Empty();
+	CurrentRun.Reset();
+	Ghosts.Empty();
+
+	Super::Deinitialize();
+}
+
+UGhostRaceSubsystem* UGhostRaceSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UGameInstance* GameInstance = UGameplayStatics::GetGameInstance(WorldContextObject);
+	return GameInstance ? GameInstance->GetSubsystem<UGhostRaceSubsystem>() : nullptr;
+}
+
+int32 UGhostRaceSubsystem::GetLayoutSeed(const UWorld* World, FIntPoint MazeSize)
+{
+	// A recorded or replayed session has its own seeds
+	const UInputReplaySubsystem* InputReplay = UInputReplaySubsystem::Get(World);
+
+	if (!World || !CVarGhostEnable.GetValueOnGameThread() || (InputReplay && (InputReplay->IsRecording() || InputReplay->IsReplaying())))
+		return 0;
+
+	const TSharedPtr<FGhostRecording> BestRun = FindBestRun(UWorld::RemovePIEPrefix(World->GetMapName()));
+
+	// A run at another thelab.Maze.Size was in another maze
+	return BestRun.IsValid() && BestRun->MazeSize == MazeSize ? BestRun->LayoutSeed : 0;
+}
+
+void UGhostRaceSubsystem::BeginRun(ACharacter* Runner, int32 LayoutSeed, FIntPoint MazeSize, TSubclassOf<AGhostRacer> GhostClass)
+{
+	EndRun(false);
+	DestroyGhosts();
+
+	if (!Runner || !CVarGhostEnable.GetValueOnGameThread())
+		return;
+
+	CurrentRun = MakeShared<FGhostRecording>();
+	CurrentRun->LayoutSeed = LayoutSeed;
+	CurrentRun->MazeSize = MazeSize;
+	CurrentMap = UWorld::RemovePIEPrefix(Runner->GetWorld()->GetMapName());
+	CurrentRunner = Runner;
+	CurrentGhostClass = GhostClass;
+
+	// The first sample is the start, the others follow at the fixed rate
+	SampleRunner();
+	Runner->GetWorldTimerManager().SetTimer(SampleTimerHandle, FTimerDelegate::CreateUObject(this, &UGhostRaceSubsystem::SampleRunner), 1.0f / FGhostRecording::SampleRate, true);
+
+	// A ghost only makes sense in the same maze
+	const TSharedPtr<FGhostRecording> BestRun = FindBestRun(CurrentMap);
+
+	if (BestRun.IsValid() && BestRun->IsSameMaze(LayoutSeed, MazeSize))
+		SpawnGhosts(1, 0.0f);
+}
+
+void UGhostRaceSubsystem::EndRun(bool bFinished)
+{
+	if (ACharacter* Runner = CurrentRunner.Get())
+		Runner->GetWorldTimerManager().ClearTimer(SampleTimerHandle);
+
+	CurrentRunner.Reset();
+
+	if (!CurrentRun.IsValid())
+		return;
+
+	TSharedPtr<FGhostRecording> FinishedRun = CurrentRun;
+	CurrentRun.Reset();
+
+	if (!bFinished || FinishedRun->NumSamples == 0)
+		return;
+
+	// A run in another maze is a different race, the latest one counts
+	const TSharedPtr<FGhostRecording> BestRun = FindBestRun(CurrentMap);
+
+	if (BestRun.IsValid() && BestRun->IsSameMaze(FinishedRun->LayoutSeed, FinishedRun->MazeSize) && BestRun->GetDuration() <= FinishedRun->GetDuration())
+		return;
+
+	UE_LOG(LogTheLab, Log, TEXT("New best run of %s: %.2f s in %d bytes (%.0f bytes per minute)"),
+		*CurrentMap, FinishedRun->GetDuration(), FinishedRun->Stream.Num(), FinishedRun->GetBytesPerMinute());
+
+	FinishedRun->Stream.Shrink();
+	BestRuns.Add(CurrentMap, FinishedRun);
+	SaveBestRun(CurrentMap, *FinishedRun);
+}
+
+void UGhostRaceSubsystem::SpawnGhosts(int32 Count, float StartInterval)
+{
+	// Ghosts race the run that is being recorded
+	ACharacter* Runner = CurrentRunner.Get();
+	const TSharedPtr<FGhostRecording> BestRun = FindBestRun(CurrentMap);
+
+	if (!Runner || !BestRun.IsValid() || !CurrentGhostClass)
+	{
+		UE_LOG(LogTheLab, Warning, TEXT("Ghosts need a run in progress, a best run of the level and a ghost class"));
+		return;
+	}
+
+	Ghosts.RemoveAll([](const TWeakObjectPtr<AGhostRacer>& Ghost) { return !Ghost.IsValid(); });
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	const int32 NumGhosts = FMath::Min(Count, CVarGhostMaxGhosts.GetValueOnGameThread() - Ghosts.Num());
+
+	for (int32 Index = 0; Index < NumGhosts; Index++)
+	{
+		AGhostRacer* Ghost = Runner->GetWorld()->SpawnActor<AGhostRacer>(CurrentGhostClass, Runner->GetActorTransform(), SpawnParams);
+
+		if (!Ghost)
+			continue;
+
+		Ghost->CopyAppearance(Runner);
+		Ghost->StartPlayback(BestRun, Index * StartInterval);
+
+		Ghosts.Add(Ghost);
+	}
+
+	SET_DWORD_STAT(STAT_TheLab_Ghosts, Ghosts.Num());
+}
+
+void UGhostRaceSubsystem::LogStats()
+{
+	for (const TPair<FString, TSharedPtr<FGhostRecording>>& Pair : BestRuns)
+	{
+		if (Pair.Value.IsValid())
+		{
+			UE_LOG(LogTheLab, Log, TEXT("Best run of %s: %.2f s, %d bytes (%.0f bytes per minute)"),
+				*Pair.Key, Pair.Value->GetDuration(), Pair.Value->Stream.Num(), Pair.Value->GetBytesPerMinute());
+		}
+	}
+
+	if (CurrentRun.IsValid())
+	{
+		UE_LOG(LogTheLab, Log, TEXT("Current run: %.2f s, %d bytes (%.0f bytes per minute)"),
+			CurrentRun->GetDuration(), CurrentRun->Stream.Num(), CurrentRun->GetBytesPerMinute());
+	}
+
+	// Game thread time of the ghosts (their pose is updated by the animation system, see "stat Anim")
+	double PlaybackSeconds = 0.0;
+	int32 NumFrames = 0;
+	int32 NumGhosts = 0;
+
+	for (const TWeakObjectPtr<AGhostRacer>& Ghost : Ghosts)
+	{
+		if (AGhostRacer* GhostRacer = Ghost.Get())
+		{
+			PlaybackSeconds += GhostRacer->GetPlaybackSeconds();
+			NumFrames = FMath::Max(NumFrames, GhostRacer->GetNumPlaybackFrames());
+			NumGhosts++;
+
+			GhostRacer->ResetTimings();
+		}
+	}
+
+	UE_LOG(LogTheLab, Log, TEXT("Ghosts: %d, playback %.2f us per ghost per frame over %d frames"),
+		NumGhosts, NumGhosts > 0 && NumFrames > 0 ? PlaybackSeconds * 1e6 / NumFrames / NumGhosts : 0.0, NumFrames);
+}
+
+FString UGhostRaceSubsystem::GetGhostPath(const FString& MapName)
+{
+	return FPaths::ProjectSavedDir() / TEXT("Ghosts") / (MapName + TEXT(".tlgh"));
+}
+
+TSharedPtr<FGhostRecording> UGhostRaceSubsystem::FindBestRun(const FString& MapName)
+{
+	if (const TSharedPtr<FGhostRecording>* BestRun = BestRuns.Find(MapName))
+		return *BestRun;
+
+	// Loaded once per map, a missing file is remembered as no best run
+	TSharedPtr<FGhostRecording>& BestRun = BestRuns.Add(MapName);
+	BestRun = MakeShared<FGhostRecording>();
+
+	// A crash while the temporary file was moved over the ghost leaves the complete run in the temporary file
+	const FString GhostPath = GetGhostPath(MapName);
+
+	if (ReadGhost(GhostPath, *BestRun))
+		return BestRun;
+
+	if (ReadGhost(GhostPath + TEXT(".tmp"), *BestRun))
+	{
+		UE_LOG(LogTheLab, Warning, TEXT("Recovered the best run of %s from %s.tmp"), *MapName, *GhostPath);
+		return BestRun;
+	}
+
+	BestRun.Reset();
+
+	return BestRun;
+}
+
+bool UGhostRaceSubsystem::ReadGhost(const FString& Path, FGhostRecording& Recording)
+{
+	TArray<uint8> Data;
+
+	if (!FFileHelper::LoadFileToArray(Data, *Path, FILEREAD_Silent))
+		return false;
+
+	FMemoryReader Reader(Data);
+	Recording.Reset();
+
+	if (!Recording.Serialize(Reader))
+	{
+		UE_LOG(LogTheLab, Warning, TEXT("Ignoring unreadable ghost %s"), *Path);
+		Recording.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+void UGhostRaceSubsystem::SampleRunner()
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_GhostRecord);
+
+	const ACharacter* Runner = CurrentRunner.Get();
+
+	if (!Runner || !CurrentRun.IsValid())
+		return;
+
+	// Too long to race, dropped so the memory stays bounded
+	if (CurrentRun->GetDuration() >= CVarGhostMaxSeconds.GetValueOnGameThread())
+	{
+		UE_LOG(LogTheLab, Log, TEXT("Run is longer than thelab.Ghost.MaxSeconds, it isn't recorded"));
+		EndRun(false);
+		return;
+	}
+
+	FGhostSample Sample;
+	Sample.Location = Runner->GetActorLocation();
+	Sample.Yaw = Runner->GetActorRotation().Yaw;
+	Sample.Speed = Runner->GetVelocity().Size2D();
+
+	CurrentRun->AddSample(Sample);
+
+	SET_DWORD_STAT(STAT_TheLab_GhostRecordingBytes, CurrentRun->Stream.Num());
+}
+
+void UGhostRaceSubsystem::DestroyGhosts()
+{
+	for (const TWeakObjectPtr<AGhostRacer>& Ghost : Ghosts)
+	{
+		if (AGhostRacer* GhostRacer = Ghost.Get())
+			GhostRacer->Destroy();
+	}
+
+	Ghosts.Reset();
+
+	SET_DWORD_STAT(STAT_TheLab_Ghosts, 0);
+}
+
+void UGhostRaceSubsystem::SaveBestRun(const FString& MapName, FGhostRecording& Recording)
+{
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+	Recording.Serialize(Writer);
+
+	// One write at a time, a newer best run replaces the file after the older one
+	if (SaveTask.IsValid())
+		SaveTask.Wait();
+
+	const FString GhostPath = GetGhostPath(MapName);
+
+	SaveTask = Async(EAsyncExecution::ThreadPool, [GhostPath, Data = MoveTemp(Data)]()
+	{
+		const FString TempPath = GhostPath + TEXT(".tmp");
+
+		// The move isn't atomic (the old ghost may be deleted before the rename), so until it is done the temporary file
+		// holds the complete run and loading falls back to it
+		if (!FFileHelper::SaveArrayToFile(Data, *TempPath) || !IFileManager::Get().Move(*GhostPath, *TempPath, true, true))
+			UE_LOG(LogTheLab, Warning, TEXT("Couldn't write ghost %s"), *GhostPath);
+	});
+}
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Async/Future.h"
+
+#include "GhostRecording.h"
+
+#include "GhostRaceSubsystem.generated.h"
+
+class ACharacter;
+class AGhostRacer;
+
+/**
+ * Records the runs of the player and races them against a ghost of their best run of the level.
+ * The runner is sampled at FGhostRecording::SampleRate into a compressed recording, a finished run that is faster
+ * than the best one replaces it and is written to Saved/Ghosts/<map>.tlgh on a worker thread.
+ * A generated maze uses the seed of the best run, so the ghost runs through the same maze.
+ * Runs are capped at thelab.Ghost.MaxSeconds and ghosts at thelab.Ghost.MaxGhosts, which bounds memory and playback cost.
+ */
+UCLASS()
+class PP_TERM4_API UGhostRaceSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	static UGhostRaceSubsystem* Get(const UObject* WorldContextObject);
+
+	// Seed of the maze of the best run of the level, when it was recorded at the size (0 when there is none)
+	int32 GetLayoutSeed(const UWorld* World, FIntPoint MazeSize);
+
+	// Starts recording the runner and spawns the ghost of the best run (when GhostClass is set)
+	void BeginRun(ACharacter* Runner, int32 LayoutSeed, FIntPoint MazeSize, TSubclassOf<AGhostRacer> GhostClass);
+
+	// Stops recording, a finished run becomes the best one when it was faster
+	void EndRun(bool bFinished);
+
+	// Spawns ghosts of the best run that start one after the other (for measuring the playback cost)
+	void SpawnGhosts(int32 Count, float StartInterval);
+
+	void LogStats();
+
+private:
+	static FString GetGhostPath(const FString& MapName);
+
+	// Reads the recording from the file, false when it is missing or unreadable
+	static bool ReadGhost(const FString& Path, FGhostRecording& Recording);
+
+	// Best run of the map, loaded from disk the first time
+	TSharedPtr<FGhostRecording> FindBestRun(const FString& MapName);
+
+	void SampleRunner();
+	void DestroyGhosts();
+	void SaveBestRun(const FString& MapName, FGhostRecording& Recording);
+
+	TMap<FString, TSharedPtr<FGhostRecording>> BestRuns;
+
+	// Run that is being recorded
+	TSharedPtr<FGhostRecording> CurrentRun;
+	FString CurrentMap;
+	TWeakObjectPtr<ACharacter> CurrentRunner;
+	TSubclassOf<AGhostRacer> CurrentGhostClass;
+	FTimerHandle SampleTimerHandle;
+
+	TArray<TWeakObjectPtr<AGhostRacer>> Ghosts;
+
+	// Best run that is being written
+	TFuture<void> SaveTask;
+};
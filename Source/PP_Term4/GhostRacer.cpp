@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GhostRacer.h"
+#include "TheLabStats.h"
+#include "Animation/AnimSingleNodeInstance.h"
+#include "Animation/BlendSpace.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Character.h"
+#include "Materials/MaterialInterface.h"
+
+// Sets default values
+AGhostRacer::AGhostRacer()
+{
+	// Only ticks while a run is played
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	Root = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+	RootComponent = Root;
+
+	// Nothing touches a ghost, and it doesn't need shadows or a pose while it isn't seen
+	Mesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("Mesh"));
+	Mesh->SetupAttachment(Root);
+	Mesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Mesh->SetGenerateOverlapEvents(false);
+	Mesh->SetCanEverAffectNavigation(false);
+	Mesh->SetCastShadow(false);
+	Mesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+	Mesh->bEnableUpdateRateOptimizations = true;
+
+	SetActorEnableCollision(false);
+
+	LocomotionBlendSpace = nullptr;
+	GhostMaterial = nullptr;
+	SampleTime = 0.0f;
+	bPlaying = false;
+	PlaybackSeconds = 0.0;
+	NumPlaybackFrames = 0;
+}
+
+// Called every frame
+void AGhostRacer::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_GhostPlayback);
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const float SampleInterval = 1.0f / FGhostRecording::SampleRate;
+
+	SampleTime += DeltaTime;
+
+	// Decode up to the sample after the playback time
+	while (bPlaying && SampleTime >= SampleInterval)
+	{
+		SampleTime -= SampleInterval;
+		PreviousSample = NextSample;
+
+		if (!Reader.Next(NextSample))
+		{
+			// Stands at the end of the run
+			bPlaying = false;
+			SetActorTickEnabled(false);
+			NextSample.Speed = 0.0f;
+			ApplySample(NextSample);
+		}
+	}
+
+	if (bPlaying && SampleTime >= 0.0f)
+	{
+		const float Alpha = SampleTime / SampleInterval;
+
+		FGhostSample Sample;
+		Sample.Location = FMath::Lerp(PreviousSample.Location, NextSample.Location, Alpha);
+		Sample.Yaw = FMath::Lerp(FRotator(0.0f, PreviousSample.Yaw, 0.0f), FRotator(0.0f, NextSample.Yaw, 0.0f), Alpha).Yaw;
+		Sample.Speed = FMath::Lerp(PreviousSample.Speed, NextSample.Speed, Alpha);
+
+		ApplySample(Sample);
+	}
+
+	PlaybackSeconds += FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+	NumPlaybackFrames++;
+}
+
+void AGhostRacer::CopyAppearance(const ACharacter* Character)
+{
+	const USkeletalMeshComponent* CharacterMesh = Character ? Character->GetMesh() : nullptr;
+
+	if (!CharacterMesh)
+		return;
+
+	// The recorded location is the one of the capsule, the mesh keeps its offset from it
+	Mesh->SetSkeletalMesh(CharacterMesh->SkeletalMesh);
+	Mesh->SetRelativeTransform(CharacterMesh->GetRelativeTransform());
+
+	if (GhostMaterial)
+	{
+		for (int32 Index = 0; Index < Mesh->GetNumMaterials(); Index++)
+			Mesh->SetMaterial(Index, GhostMaterial);
+	}
+
+	if (LocomotionBlendSpace)
+		Mesh->PlayAnimation(LocomotionBlendSpace, true);
+}
+
+void AGhostRacer::StartPlayback(TSharedPtr<const FGhostRecording> InRecording, float StartDelay)
+{
+	Reader.Start(InRecording);
+
+	// Waits at the first sample until the delay is over, a run of one sample stays on it
+	bPlaying = Reader.Next(PreviousSample);
+	NextSample = PreviousSample;
+
+	if (bPlaying)
+	{
+		Reader.Next(NextSample);
+		ApplySample(PreviousSample);
+	}
+
+	SampleTime = -StartDelay;
+	SetActorTickEnabled(bPlaying);
+}
+
+void AGhostRacer::ResetTimings()
+{
+	PlaybackSeconds = 0.0;
+	NumPlaybackFrames = 0;
+}
+
+void AGhostRacer::ApplySample(const FGhostSample& Sample)
+{
+	SetActorLocationAndRotation(Sample.Location, FRotator(0.0f, Sample.Yaw, 0.0f));
+
+	if (UAnimSingleNodeInstance* Animation = Mesh->GetSingleNodeInstance())
+		Animation->SetBlendSpaceInput(FVector(Sample.Speed, 0.0f, 0.0f));
+}
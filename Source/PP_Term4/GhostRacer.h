@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+
+#include "GhostRecording.h"
+
+#include "GhostRacer.generated.h"
+
+class ACharacter;
+class UBlendSpace;
+class UMaterialInterface;
+class USkeletalMeshComponent;
+
+/**
+ * Plays a recorded run back on a skeletal mesh, without a movement component or collision.
+ * The samples are decoded as the playback reaches them and interpolated in between, and the speed drives a locomotion
+ * blend space played on the mesh directly (no animation blueprint). The pose is only updated while the ghost is rendered.
+ */
+UCLASS()
+class PP_TERM4_API AGhostRacer : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AGhostRacer();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	// Takes the mesh of the character that recorded the run
+	void CopyAppearance(const ACharacter* Character);
+
+	// Plays the run from the start, StartDelay seconds from now
+	void StartPlayback(TSharedPtr<const FGhostRecording> InRecording, float StartDelay = 0.0f);
+
+	bool IsPlaying() const { return bPlaying; }
+
+	// Time spent in Tick since the last reset
+	double GetPlaybackSeconds() const { return PlaybackSeconds; }
+	int32 GetNumPlaybackFrames() const { return NumPlaybackFrames; }
+	void ResetTimings();
+
+	// Locomotion blend space, the speed in cm/s is its horizontal input
+	UPROPERTY(EditAnywhere, Category = "Ghost")
+		UBlendSpace* LocomotionBlendSpace;
+
+	// Replaces every material of the mesh (a translucent one makes it look like a ghost)
+	UPROPERTY(EditAnywhere, Category = "Ghost")
+		UMaterialInterface* GhostMaterial;
+
+private:
+	void ApplySample(const FGhostSample& Sample);
+
+	UPROPERTY(VisibleAnywhere, Category = "Ghost")
+		USceneComponent* Root;
+
+	UPROPERTY(VisibleAnywhere, Category = "Ghost")
+		USkeletalMeshComponent* Mesh;
+
+	FGhostReader Reader;
+
+	// Samples around the playback time
+	FGhostSample PreviousSample;
+	FGhostSample NextSample;
+
+	// Seconds from the previous to the playback time (negative before the start)
+	float SampleTime;
+
+	bool bPlaying;
+
+	double PlaybackSeconds;
+	int32 NumPlaybackFrames;
+};
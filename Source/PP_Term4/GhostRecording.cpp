@@ -0,0 +1,194 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GhostRecording.h"
+
+// Identifies a ghost recording ("TLGH")
+static const uint32 GhostRecordingMagic = 0x48474C54;
+
+// Values that changed since the previous sample
+enum EGhostSampleFlags : uint8
+{
+	GhostChangedX = 1 << 0,
+	GhostChangedY = 1 << 1,
+	GhostChangedZ = 1 << 2,
+	GhostChangedYaw = 1 << 3,
+	GhostChangedSpeed = 1 << 4
+};
+
+// Quantization steps
+static const float GhostSpeedStep = 4.0f;
+static const float GhostYawSteps = 65536.0f;
+
+// Small deltas of either sign fit in one byte: 0, -1, 1, -2, 2, ...
+static uint32 ZigZagEncode(int32 Value)
+{
+	return ((uint32)Value << 1) ^ (uint32)(Value >> 31);
+}
+
+static int32 ZigZagDecode(uint32 Value)
+{
+	return (int32)(Value >> 1) ^ -(int32)(Value & 1);
+}
+
+// Seven bits per byte, the high bit says another byte follows
+static void WriteVarInt(TArray<uint8>& Stream, int32 Value)
+{
+	uint32 Encoded = ZigZagEncode(Value);
+
+	while (Encoded >= 0x80)
+	{
+		Stream.Add((uint8)(Encoded | 0x80));
+		Encoded >>= 7;
+	}
+
+	Stream.Add((uint8)Encoded);
+}
+
+static bool ReadVarInt(const TArray<uint8>& Stream, int32& Offset, int32& OutValue)
+{
+	uint32 Encoded = 0;
+
+	for (int32 Shift = 0; Shift < 35; Shift += 7)
+	{
+		if (!Stream.IsValidIndex(Offset))
+			return false;
+
+		const uint8 Byte = Stream[Offset++];
+		Encoded |= (uint32)(Byte & 0x7F) << Shift;
+
+		if ((Byte & 0x80) == 0)
+		{
+			OutValue = ZigZagDecode(Encoded);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FGhostRecording::AddSample(const FGhostSample& Sample)
+{
+	const FIntVector Location(FMath::RoundToInt(Sample.Location.X), FMath::RoundToInt(Sample.Location.Y), FMath::RoundToInt(Sample.Location.Z));
+	const uint16 Yaw = (uint16)(FMath::RoundToInt(FRotator::ClampAxis(Sample.Yaw) / 360.0f * GhostYawSteps) & 0xFFFF);
+	const int32 Speed = FMath::Clamp(FMath::RoundToInt(Sample.Speed / GhostSpeedStep), 0, MAX_uint16);
+
+	// The first sample is a delta from zero
+	uint8 Flags = 0;
+
+	if (Location.X != LastLocation.X)
+		Flags |= GhostChangedX;
+	if (Location.Y != LastLocation.Y)
+		Flags |= GhostChangedY;
+	if (Location.Z != LastLocation.Z)
+		Flags |= GhostChangedZ;
+	if (Yaw != LastYaw)
+		Flags |= GhostChangedYaw;
+	if (Speed != LastSpeed)
+		Flags |= GhostChangedSpeed;
+
+	Stream.Add(Flags);
+
+	if (Flags & GhostChangedX)
+		WriteVarInt(Stream, Location.X - LastLocation.X);
+	if (Flags & GhostChangedY)
+		WriteVarInt(Stream, Location.Y - LastLocation.Y);
+	if (Flags & GhostChangedZ)
+		WriteVarInt(Stream, Location.Z - LastLocation.Z);
+
+	// The yaw wraps around, so the delta is the short way
+	if (Flags & GhostChangedYaw)
+		WriteVarInt(Stream, (int16)(uint16)(Yaw - LastYaw));
+
+	if (Flags & GhostChangedSpeed)
+		WriteVarInt(Stream, Speed - LastSpeed);
+
+	LastLocation = Location;
+	LastYaw = Yaw;
+	LastSpeed = Speed;
+
+	NumSamples++;
+}
+
+void FGhostRecording::Reset()
+{
+	LayoutSeed = 0;
+	MazeSize = FIntPoint::ZeroValue;
+	NumSamples = 0;
+	Stream.Reset();
+
+	LastLocation = FIntVector::ZeroValue;
+	LastYaw = 0;
+	LastSpeed = 0;
+}
+
+float FGhostRecording::GetBytesPerMinute() const
+{
+	return NumSamples > 0 ? Stream.Num() * 60.0f / GetDuration() : 0.0f;
+}
+
+bool FGhostRecording::Serialize(FArchive& Ar)
+{
+	uint32 Magic = GhostRecordingMagic;
+	uint16 Version = LatestVersion;
+
+	Ar << Magic;
+	Ar << Version;
+
+	if (Ar.IsError() || Magic != GhostRecordingMagic || Version == 0 || Version > LatestVersion)
+		return false;
+
+	// Version 1
+	Ar << LayoutSeed;
+	Ar << NumSamples;
+	Ar << Stream;
+
+	// Version 2
+	if (Version >= 2)
+		Ar << MazeSize;
+
+	return !Ar.IsError() && NumSamples >= 0;
+}
+
+void FGhostReader::Start(TSharedPtr<const FGhostRecording> InRecording)
+{
+	Recording = InRecording;
+
+	Offset = 0;
+	Sample = 0;
+
+	Location = FIntVector::ZeroValue;
+	Yaw = 0;
+	Speed = 0;
+}
+
+bool FGhostReader::Next(FGhostSample& OutSample)
+{
+	if (!Recording.IsValid() || Sample >= Recording->NumSamples || !Recording->Stream.IsValidIndex(Offset))
+		return false;
+
+	const TArray<uint8>& Stream = Recording->Stream;
+	const uint8 Flags = Stream[Offset++];
+
+	int32 DeltaX = 0, DeltaY = 0, DeltaZ = 0, DeltaYaw = 0, DeltaSpeed = 0;
+
+	// Only the deltas of the flagged values follow, in order
+	if (((Flags & GhostChangedX) && !ReadVarInt(Stream, Offset, DeltaX))
+		|| ((Flags & GhostChangedY) && !ReadVarInt(Stream, Offset, DeltaY))
+		|| ((Flags & GhostChangedZ) && !ReadVarInt(Stream, Offset, DeltaZ))
+		|| ((Flags & GhostChangedYaw) && !ReadVarInt(Stream, Offset, DeltaYaw))
+		|| ((Flags & GhostChangedSpeed) && !ReadVarInt(Stream, Offset, DeltaSpeed)))
+		return false;
+
+	Location += FIntVector(DeltaX, DeltaY, DeltaZ);
+	Yaw += (uint16)DeltaYaw;
+	Speed += DeltaSpeed;
+
+	OutSample.Location = FVector(Location);
+	OutSample.Yaw = Yaw / GhostYawSteps * 360.0f;
+	OutSample.Speed = Speed * GhostSpeedStep;
+
+	Sample++;
+
+	return true;
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// One sample of a recorded run
+struct FGhostSample
+{
+	FVector Location = FVector::ZeroVector;
+	float Yaw = 0.0f;
+
+	// Ground speed, drives the locomotion animation
+	float Speed = 0.0f;
+};
+
+/**
+ * A run recorded at a fixed rate as a quantized, delta compressed byte stream.
+ * Locations are quantized to centimeters, the yaw to 1/65536 of a turn and the speed to 4 cm/s. Every sample is a
+ * byte with the values that changed followed by their zigzag varint deltas, so standing still costs one byte
+ * per sample and running three to five (a few KB per recorded minute).
+ */
+struct PP_TERM4_API FGhostRecording
+{
+	// Bumped when the layout of Serialize changes
+	static const uint16 LatestVersion = 2;
+
+	// Samples per second
+	static constexpr float SampleRate = 20.0f;
+
+	// Seed of the generated maze the run was recorded in (0 when the level isn't generated)
+	int32 LayoutSeed = 0;
+
+	// Cells of that maze, the same seed carves another maze at another size (zero when it isn't known)
+	FIntPoint MazeSize = FIntPoint::ZeroValue;
+
+	int32 NumSamples = 0;
+	TArray<uint8> Stream;
+
+	// Encodes the sample after the previous one
+	void AddSample(const FGhostSample& Sample);
+
+	void Reset();
+
+	// Whether the run was recorded in the maze generated with the seed at the size
+	bool IsSameMaze(int32 Seed, FIntPoint Size) const { return LayoutSeed == Seed && MazeSize == Size; }
+
+	float GetDuration() const { return NumSamples / SampleRate; }
+	float GetBytesPerMinute() const;
+
+	// Reads or writes the recording (returns false when the data isn't a ghost recording)
+	bool Serialize(FArchive& Ar);
+
+private:
+	// Quantized values of the last sample
+	FIntVector LastLocation = FIntVector::ZeroValue;
+	uint16 LastYaw = 0;
+	int32 LastSpeed = 0;
+};
+
+// Decodes a recording one sample at a time, so playing it back keeps it compressed
+class PP_TERM4_API FGhostReader
+{
+public:
+	void Start(TSharedPtr<const FGhostRecording> InRecording);
+
+	// Decodes the next sample (returns false at the end of the run)
+	bool Next(FGhostSample& OutSample);
+
+private:
+	TSharedPtr<const FGhostRecording> Recording;
+
+	int32 Offset = 0;
+	int32 Sample = 0;
+
+	FIntVector Location = FIntVector::ZeroValue;
+	uint16 Yaw = 0;
+	int32 Speed = 0;
+};
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HUDDataComponent.h"
+
+// Sets default values for this component's properties
+UHUDDataComponent::UHUDDataComponent()
+{
+	// The values are pushed, so it never has to tick
+	PrimaryComponentTick.bCanEverTick = false;
+
+	DisplayedHealth = INDEX_NONE;
+	DisplayedSeconds = INDEX_NONE;
+	CollectedCoins = INDEX_NONE;
+	CoinsToCollect = INDEX_NONE;
+}
+
+float UHUDDataComponent::GetSecondsUntilDisplayChange(float Value, float DrainPerSecond)
+{
+	if (DrainPerSecond <= 0.0f || Value <= 0.0f)
+		return TNumericLimits<float>::Max();
+
+	// The displayed value changes when the value drops below the next lower whole number
+	const float NextDisplayedValue = FMath::CeilToFloat(Value) - 1.0f;
+
+	return (Value - NextDisplayedValue) / DrainPerSecond;
+}
+
+void UHUDDataComponent::SetHealth(float Health)
+{
+	const int32 NewHealth = FMath::CeilToInt(Health);
+
+	if (NewHealth == DisplayedHealth)
+		return;
+
+	DisplayedHealth = NewHealth;
+	OnHealthChanged.Broadcast(DisplayedHealth);
+}
+
+void UHUDDataComponent::SetTimeRemaining(float Seconds)
+{
+	const int32 NewSeconds = FMath::CeilToInt(Seconds);
+
+	if (NewSeconds == DisplayedSeconds)
+		return;
+
+	DisplayedSeconds = NewSeconds;
+	OnTimerSecondChanged.Broadcast(DisplayedSeconds);
+}
+
+void UHUDDataComponent::SetCoins(int32 Collected, int32 ToCollect)
+{
+	if (Collected == CollectedCoins && ToCollect == CoinsToCollect)
+		return;
+
+	CollectedCoins = Collected;
+	CoinsToCollect = ToCollect;
+	OnCoinsChanged.Broadcast(CollectedCoins, CoinsToCollect);
+}
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+
+#include "HUDDataComponent.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHUDHealthChanged, int32, Health);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHUDTimerSecondChanged, int32, Seconds);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnHUDCoinsChanged, int32, Collected, int32, ToCollect);
+
+/**
+ * Values the HUD of a mini-game shows, pushed by the character.
+ * The delegates only fire when the displayed (whole) value changes, so the UI never has to poll the character.
+ */
+UCLASS(ClassGroup = (TheLab), meta = (BlueprintSpawnableComponent))
+class PP_TERM4_API UHUDDataComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UHUDDataComponent();
+
+	// Seconds until the whole value of a draining value changes (the display rounds up)
+	static float GetSecondsUntilDisplayChange(float Value, float DrainPerSecond);
+
+	void SetHealth(float Health);
+	void SetTimeRemaining(float Seconds);
+	void SetCoins(int32 Collected, int32 ToCollect);
+
+	UFUNCTION(BlueprintPure, Category = "HUD")
+		int32 GetHealth() const { return DisplayedHealth; }
+
+	UFUNCTION(BlueprintPure, Category = "HUD")
+		int32 GetTimerSeconds() const { return DisplayedSeconds; }
+
+	UFUNCTION(BlueprintPure, Category = "HUD")
+		int32 GetCollectedCoins() const { return CollectedCoins; }
+
+	UFUNCTION(BlueprintPure, Category = "HUD")
+		int32 GetCoinsToCollect() const { return CoinsToCollect; }
+
+	UPROPERTY(BlueprintAssignable, Category = "HUD")
+		FOnHUDHealthChanged OnHealthChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = "HUD")
+		FOnHUDTimerSecondChanged OnTimerSecondChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = "HUD")
+		FOnHUDCoinsChanged OnCoinsChanged;
+
+private:
+	int32 DisplayedHealth;
+	int32 DisplayedSeconds;
+	int32 CollectedCoins;
+	int32 CoinsToCollect;
+};
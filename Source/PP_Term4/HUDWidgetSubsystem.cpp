@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HUDWidgetSubsystem.h"
+#include "TheLabStats.h"
+#include "Engine/Engine.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+void UHUDWidgetSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddUObject(this, &UHUDWidgetSubsystem::OnWorldCleanup);
+}
+
+void UHUDWidgetSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupHandle);
+	Widgets.Empty();
+
+	Super::Deinitialize();
+}
+
+UHUDWidgetSubsystem* UHUDWidgetSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	ULocalPlayer* LocalPlayer = World ? World->GetFirstLocalPlayerFromController() : nullptr;
+
+	return LocalPlayer ? LocalPlayer->GetSubsystem<UHUDWidgetSubsystem>() : nullptr;
+}
+
+UUserWidget* UHUDWidgetSubsystem::Prewarm(TSubclassOf<UUserWidget> WidgetClass)
+{
+	if (!WidgetClass)
+		return nullptr;
+
+	if (FPooledHUDWidget* PooledWidget = Widgets.Find(WidgetClass))
+		return PooledWidget->Widget;
+
+	APlayerController* PlayerController = GetLocalPlayer()->GetPlayerController(nullptr);
+
+	if (!PlayerController)
+		return nullptr;
+
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_CreateWidget);
+
+	UUserWidget* Widget = CreateWidget(PlayerController, WidgetClass);
+
+	if (!Widget)
+		return nullptr;
+
+	WidgetWorld = PlayerController->GetWorld();
+
+	// Remember how the widget wants to be shown, then build it collapsed
+	FPooledHUDWidget& PooledWidget = Widgets.Add(WidgetClass);
+	PooledWidget.Widget = Widget;
+	PooledWidget.ShownVisibility = Widget->GetVisibility();
+
+	Widget->SetVisibility(ESlateVisibility::Collapsed);
+	Widget->AddToViewport();
+
+	SET_DWORD_STAT(STAT_TheLab_HUDWidgets, Widgets.Num());
+
+	return Widget;
+}
+
+UUserWidget* UHUDWidgetSubsystem::Show(TSubclassOf<UUserWidget> WidgetClass)
+{
+	UUserWidget* Widget = Prewarm(WidgetClass);
+
+	if (Widget)
+		Widget->SetVisibility(Widgets[WidgetClass].ShownVisibility);
+
+	return Widget;
+}
+
+void UHUDWidgetSubsystem::Hide(TSubclassOf<UUserWidget> WidgetClass)
+{
+	if (const FPooledHUDWidget* PooledWidget = Widgets.Find(WidgetClass))
+		PooledWidget->Widget->SetVisibility(ESlateVisibility::Collapsed);
+}
+
+void UHUDWidgetSubsystem::Release(TSubclassOf<UUserWidget> WidgetClass)
+{
+	FPooledHUDWidget PooledWidget;
+
+	if (!Widgets.RemoveAndCopyValue(WidgetClass, PooledWidget))
+		return;
+
+	if (PooledWidget.Widget)
+		PooledWidget.Widget->RemoveFromParent();
+
+	SET_DWORD_STAT(STAT_TheLab_HUDWidgets, Widgets.Num());
+}
+
+bool UHUDWidgetSubsystem::IsShown(TSubclassOf<UUserWidget> WidgetClass) const
+{
+	const FPooledHUDWidget* PooledWidget = Widgets.Find(WidgetClass);
+
+	return PooledWidget && PooledWidget->Widget->GetVisibility() != ESlateVisibility::Collapsed;
+}
+
+void UHUDWidgetSubsystem::OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+	if (World != WidgetWorld.Get())
+		return;
+
+	// The widgets belong to the world that is going away
+	for (const TPair<UClass*, FPooledHUDWidget>& Pair : Widgets)
+	{
+		if (Pair.Value.Widget)
+			Pair.Value.Widget->RemoveFromParent();
+	}
+
+	Widgets.Empty();
+	WidgetWorld.Reset();
+
+	SET_DWORD_STAT(STAT_TheLab_HUDWidgets, 0);
+}
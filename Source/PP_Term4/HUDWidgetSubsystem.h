@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/LocalPlayerSubsystem.h"
+#include "Blueprint/UserWidget.h"
+
+#include "HUDWidgetSubsystem.generated.h"
+
+// A pooled widget and the visibility it is shown with
+USTRUCT()
+struct FPooledHUDWidget
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		UUserWidget* Widget = nullptr;
+
+	ESlateVisibility ShownVisibility = ESlateVisibility::SelfHitTestInvisible;
+};
+
+/**
+ * Keeps one instance of every HUD widget class of the local player.
+ * Widgets are created and added to the viewport collapsed while the level loads,
+ * so showing or hiding them during gameplay is only a visibility change.
+ * The pool is emptied when the world it was built for is cleaned up.
+ */
+UCLASS()
+class PP_TERM4_API UHUDWidgetSubsystem : public ULocalPlayerSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Returns the subsystem of the first local player of the world
+	static UHUDWidgetSubsystem* Get(const UObject* WorldContextObject);
+
+	// Builds the widget of the class once and keeps it collapsed
+	UUserWidget* Prewarm(TSubclassOf<UUserWidget> WidgetClass);
+
+	// Shows the widget of the class (builds it when it wasn't prewarmed)
+	UUserWidget* Show(TSubclassOf<UUserWidget> WidgetClass);
+	void Hide(TSubclassOf<UUserWidget> WidgetClass);
+
+	// Removes the widget of the class from the viewport and the pool (for the UI of a streamed mini-game that is unloaded)
+	void Release(TSubclassOf<UUserWidget> WidgetClass);
+
+	bool IsShown(TSubclassOf<UUserWidget> WidgetClass) const;
+
+private:
+	void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
+
+	UPROPERTY()
+		TMap<UClass*, FPooledHUDWidget> Widgets;
+
+	// World the widgets were built for
+	TWeakObjectPtr<UWorld> WidgetWorld;
+
+	FDelegateHandle WorldCleanupHandle;
+};
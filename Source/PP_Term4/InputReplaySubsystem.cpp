@@ -0,0 +1,427 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InputReplaySubsystem.h"
+#include "PP_Term4.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+// Identifies an input recording ("TLIN") and the version of its layout
+static const uint32 RecordingMagic = 0x4E494C54;
+static const uint16 RecordingVersion = 1;
+
+// Recorded inputs, the index is stored in the recording so only append to these
+static const FName RecordedAxes[] =
+{
+	TEXT("Move Forward / Backward"),
+	TEXT("Move Right / Left"),
+	TEXT("Turn Right / Left Mouse"),
+	TEXT("Look Up / Down Mouse"),
+	TEXT("Turn Right / Left Gamepad"),
+	TEXT("Look Up / Down Gamepad"),
+	TEXT("Wheel")
+};
+
+static const FName RecordedActions[] =
+{
+	TEXT("Jump"),
+	TEXT("Sprint"),
+	TEXT("StartLevel"),
+	TEXT("Pickup")
+};
+
+// Layout of a frame: a mask byte (bit per changed axis, FrameHasEvents), the changed axis values, then the action events
+static const int32 NumRecordedAxes = UE_ARRAY_COUNT(RecordedAxes);
+static const int32 NumRecordedActions = UE_ARRAY_COUNT(RecordedActions) * 2;
+static const uint8 FrameHasEvents = 0x80;
+
+static_assert(NumRecordedAxes < 8, "The axis mask of a frame is one byte");
+
+void UInputReplaySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+
+	FString Name;
+	float FramesPerSecond = 60.0f;
+
+	FParse::Value(CommandLine, TEXT("TheLabReplayFPS="), FramesPerSecond);
+	FixedDeltaTime = 1.0f / FMath::Max(FramesPerSecond, 1.0f);
+
+	Mode = EMode::None;
+
+	if (FParse::Value(CommandLine, TEXT("TheLabReplayInput="), Name))
+	{
+		RecordingPath = GetRecordingPath(Name);
+
+		if (ReadRecording())
+			Mode = EMode::Replay;
+		else
+			UE_LOG(LogTheLab, Error, TEXT("Couldn't read input recording %s"), *RecordingPath);
+	}
+	else if (FParse::Value(CommandLine, TEXT("TheLabRecordInput="), Name))
+	{
+		RecordingPath = GetRecordingPath(Name);
+		Mode = EMode::Record;
+	}
+
+	SegmentIndex = INDEX_NONE;
+	bFrameOpen = false;
+	ReadOffset = 0;
+	ReadFrame = 0;
+
+	AxisValues.Init(0.0f, NumRecordedAxes);
+	CommittedAxisValues.Init(0.0f, NumRecordedAxes);
+	ActionHandlers.SetNum(NumRecordedActions);
+
+	if (Mode == EMode::None)
+		return;
+
+	// Frames have the same length in the recording and the replay
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(FixedDeltaTime);
+
+	WorldTickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &UInputReplaySubsystem::OnWorldTickStart);
+
+	UE_LOG(LogTheLab, Log, TEXT("%s input %s at %.0f frames per second"), Mode == EMode::Record ? TEXT("Recording") : TEXT("Replaying"), *RecordingPath, 1.0f / FixedDeltaTime);
+}
+
+void UInputReplaySubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldTickStart.Remove(WorldTickStartHandle);
+
+	EndSegment();
+
+	Super::Deinitialize();
+}
+
+UInputReplaySubsystem* UInputReplaySubsystem::Get(const UObject* WorldContextObject)
+{
+	const UGameInstance* GameInstance = UGameplayStatics::GetGameInstance(WorldContextObject);
+	return GameInstance ? GameInstance->GetSubsystem<UInputReplaySubsystem>() : nullptr;
+}
+
+int32 UInputReplaySubsystem::GetRandomSeed(const UObject* WorldContextObject)
+{
+	UInputReplaySubsystem* InputReplay = Get(WorldContextObject);
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+
+	if (!InputReplay || InputReplay->Mode == EMode::None || !World)
+		return FMath::Rand();
+
+	// Called before the first tick of the world (from BeginPlay), so the segment may not exist yet
+	if (World != InputReplay->SegmentWorld.Get())
+		InputReplay->BeginSegment(World);
+
+	return InputReplay->Segments.IsValidIndex(InputReplay->SegmentIndex) ? InputReplay->Segments[InputReplay->SegmentIndex].RandomSeed : FMath::Rand();
+}
+
+int32 UInputReplaySubsystem::GetAxisChannel(FName AxisName)
+{
+	for (int32 Channel = 0; Channel < NumRecordedAxes; Channel++)
+	{
+		if (RecordedAxes[Channel] == AxisName)
+			return Channel;
+	}
+
+	return INDEX_NONE;
+}
+
+int32 UInputReplaySubsystem::GetActionId(FName ActionName, EInputEvent KeyEvent)
+{
+	if (KeyEvent != IE_Pressed && KeyEvent != IE_Released)
+		return INDEX_NONE;
+
+	for (int32 Index = 0; Index < NumRecordedActions / 2; Index++)
+	{
+		if (RecordedActions[Index] == ActionName)
+			return Index * 2 + (KeyEvent == IE_Released ? 1 : 0);
+	}
+
+	return INDEX_NONE;
+}
+
+FString UInputReplaySubsystem::GetRecordingPath(const FString& Name)
+{
+	return FPaths::ProjectSavedDir() / TEXT("InputRecordings") / (Name + TEXT(".tlin"));
+}
+
+float UInputReplaySubsystem::FilterAxis(int32 Channel, float Value)
+{
+	if (Mode == EMode::Record)
+		AxisValues[Channel] = Value;
+	else if (Mode == EMode::Replay)
+		return AxisValues[Channel];
+
+	return Value;
+}
+
+bool UInputReplaySubsystem::FilterAction(int32 Action)
+{
+	if (Mode == EMode::Record && ActionEvents.Num() < MAX_uint8)
+		ActionEvents.Add((uint8)Action);
+
+	// The live input is ignored while replaying
+	return Mode != EMode::Replay;
+}
+
+void UInputReplaySubsystem::OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (!World->IsGameWorld())
+		return;
+
+	if (World != SegmentWorld.Get())
+		BeginSegment(World);
+
+	// The input of a frame is committed when the next frame starts, and replayed before the frame is ticked
+	if (Mode == EMode::Record)
+	{
+		if (bFrameOpen)
+			CommitFrame();
+
+		bFrameOpen = true;
+	}
+	else if (Mode == EMode::Replay)
+		ReplayFrame();
+}
+
+void UInputReplaySubsystem::BeginSegment(UWorld* World)
+{
+	EndSegment();
+
+	SegmentWorld = World;
+	SegmentIndex++;
+
+	bFrameOpen = false;
+	ReadOffset = 0;
+	ReadFrame = 0;
+
+	ActionEvents.Reset();
+
+	for (int32 Channel = 0; Channel < NumRecordedAxes; Channel++)
+	{
+		AxisValues[Channel] = 0.0f;
+		CommittedAxisValues[Channel] = 0.0f;
+	}
+
+	if (Mode == EMode::Record)
+	{
+		FInputReplaySegment& Segment = Segments.AddDefaulted_GetRef();
+		Segment.MapName = World->GetName();
+		Segment.RandomSeed = FMath::Rand();
+	}
+	else if (!Segments.IsValidIndex(SegmentIndex))
+		UE_LOG(LogTheLab, Warning, TEXT("Input recording has no segment for %s"), *World->GetName());
+	else if (Segments[SegmentIndex].MapName != World->GetName())
+		UE_LOG(LogTheLab, Warning, TEXT("Input recording segment of %s is replayed in %s"), *Segments[SegmentIndex].MapName, *World->GetName());
+}
+
+void UInputReplaySubsystem::EndSegment()
+{
+	if (Mode == EMode::Record && Segments.IsValidIndex(SegmentIndex))
+	{
+		if (bFrameOpen)
+			CommitFrame();
+
+		bFrameOpen = false;
+
+		if (!WriteRecording())
+			UE_LOG(LogTheLab, Error, TEXT("Couldn't write input recording %s"), *RecordingPath);
+	}
+
+	SegmentWorld.Reset();
+}
+
+void UInputReplaySubsystem::CommitFrame()
+{
+	FInputReplaySegment& Segment = Segments[SegmentIndex];
+
+	// Only the axes that changed since the previous frame are stored
+	uint8 Mask = ActionEvents.Num() > 0 ? FrameHasEvents : 0;
+
+	for (int32 Channel = 0; Channel < NumRecordedAxes; Channel++)
+	{
+		if (AxisValues[Channel] != CommittedAxisValues[Channel])
+			Mask |= 1 << Channel;
+	}
+
+	Segment.Frames.Add(Mask);
+
+	for (int32 Channel = 0; Channel < NumRecordedAxes; Channel++)
+	{
+		if (Mask & (1 << Channel))
+		{
+			Segment.Frames.Append((const uint8*)&AxisValues[Channel], sizeof(float));
+			CommittedAxisValues[Channel] = AxisValues[Channel];
+		}
+
+		// Axes that aren't read in a frame count as 0
+		AxisValues[Channel] = 0.0f;
+	}
+
+	if (Mask & FrameHasEvents)
+	{
+		Segment.Frames.Add((uint8)ActionEvents.Num());
+		Segment.Frames.Append(ActionEvents);
+	}
+
+	Segment.NumFrames++;
+	ActionEvents.Reset();
+}
+
+void UInputReplaySubsystem::ReplayFrame()
+{
+	if (!Segments.IsValidIndex(SegmentIndex))
+		return;
+
+	const FInputReplaySegment& Segment = Segments[SegmentIndex];
+
+	if (ReadFrame >= Segment.NumFrames || ReadOffset >= Segment.Frames.Num())
+	{
+		// Stop the input once, the world keeps running without it
+		if (ReadFrame != MAX_int32)
+		{
+			UE_LOG(LogTheLab, Log, TEXT("Input replay of %s finished after %d frames"), *Segment.MapName, ReadFrame);
+			StopReplayInput();
+		}
+
+		return;
+	}
+
+	const uint8* Data = Segment.Frames.GetData();
+	const int32 NumBytes = Segment.Frames.Num();
+
+	// A truncated or corrupt recording stops the replay instead of reading past the frames
+	auto HasBytes = [this, NumBytes](int32 Count) { return ReadOffset + Count <= NumBytes; };
+	auto StopTruncated = [this, &Segment]()
+	{
+		UE_LOG(LogTheLab, Warning, TEXT("Input replay of %s is truncated at frame %d, stopping the replay"), *Segment.MapName, ReadFrame);
+		StopReplayInput();
+	};
+
+	const uint8 Mask = Data[ReadOffset++];
+
+	for (int32 Channel = 0; Channel < NumRecordedAxes; Channel++)
+	{
+		if (Mask & (1 << Channel))
+		{
+			if (!HasBytes(sizeof(float)))
+			{
+				StopTruncated();
+				return;
+			}
+
+			FMemory::Memcpy(&AxisValues[Channel], Data + ReadOffset, sizeof(float));
+			ReadOffset += sizeof(float);
+		}
+	}
+
+	if (Mask & FrameHasEvents)
+	{
+		if (!HasBytes(1))
+		{
+			StopTruncated();
+			return;
+		}
+
+		const int32 NumEvents = Data[ReadOffset++];
+
+		for (int32 Index = 0; Index < NumEvents; Index++)
+		{
+			if (!HasBytes(1))
+			{
+				StopTruncated();
+				return;
+			}
+
+			const int32 Action = Data[ReadOffset++];
+
+			if (ActionHandlers.IsValidIndex(Action))
+				ActionHandlers[Action].ExecuteIfBound();
+		}
+	}
+
+	ReadFrame++;
+}
+
+void UInputReplaySubsystem::StopReplayInput()
+{
+	for (int32 Channel = 0; Channel < NumRecordedAxes; Channel++)
+		AxisValues[Channel] = 0.0f;
+
+	ReadFrame = MAX_int32;
+}
+
+bool UInputReplaySubsystem::WriteRecording()
+{
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+
+	uint32 Magic = RecordingMagic;
+	uint16 Version = RecordingVersion;
+	float DeltaTime = FixedDeltaTime;
+	int32 NumSegments = Segments.Num();
+
+	Writer << Magic << Version << DeltaTime << NumSegments;
+
+	for (FInputReplaySegment& Segment : Segments)
+		Writer << Segment.MapName << Segment.RandomSeed << Segment.NumFrames << Segment.Frames;
+
+	return FFileHelper::SaveArrayToFile(Data, *RecordingPath);
+}
+
+bool UInputReplaySubsystem::ReadRecording()
+{
+	TArray<uint8> Data;
+
+	if (!FFileHelper::LoadFileToArray(Data, *RecordingPath))
+		return false;
+
+	FMemoryReader Reader(Data);
+
+	uint32 Magic = 0;
+	uint16 Version = 0;
+	float DeltaTime = 0.0f;
+	int32 NumSegments = 0;
+
+	Reader << Magic << Version << DeltaTime << NumSegments;
+
+	if (Reader.IsError() || Magic != RecordingMagic || Version != RecordingVersion)
+		return false;
+
+	// The counts come from the file, so a corrupt one must not decide how much is allocated
+	// (the smallest segment is an empty map name, the seed, the frame count and an empty frame array)
+	const int64 MinSegmentSize = sizeof(int32) * 4;
+
+	if (!FMath::IsFinite(DeltaTime) || DeltaTime <= 0.0f || DeltaTime > 1.0f)
+		return false;
+
+	if (NumSegments < 0 || NumSegments > (Reader.TotalSize() - Reader.Tell()) / MinSegmentSize)
+		return false;
+
+	FixedDeltaTime = DeltaTime;
+	Segments.SetNum(NumSegments);
+
+	for (FInputReplaySegment& Segment : Segments)
+	{
+		int32 NumBytes = 0;
+
+		Reader << Segment.MapName << Segment.RandomSeed << Segment.NumFrames << NumBytes;
+
+		if (Reader.IsError() || Segment.NumFrames < 0 || NumBytes < 0 || NumBytes > Reader.TotalSize() - Reader.Tell())
+			return false;
+
+		Segment.Frames.SetNumUninitialized(NumBytes);
+		Reader.Serialize(Segment.Frames.GetData(), NumBytes);
+	}
+
+	return !Reader.IsError();
+}
@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Components/InputComponent.h"
+
+#include "InputReplaySubsystem.generated.h"
+
+// Input and random seed of one world in a recording
+struct FInputReplaySegment
+{
+	FString MapName;
+	int32 RandomSeed = 0;
+	int32 NumFrames = 0;
+
+	// Delta encoded frames (see UInputReplaySubsystem::CommitFrame)
+	TArray<uint8> Frames;
+};
+
+/**
+ * Records the input of the player (per frame axis values and action events) and the random seed of every world,
+ * and feeds a recording back, so two builds can be profiled on the same session.
+ * -TheLabRecordInput=<name> records and -TheLabReplayInput=<name> replays Saved/InputRecordings/<name>.tlin.
+ * Both run at a fixed timestep (-TheLabReplayFPS, 60 by default). Without either option the input passes through.
+ *
+ * The characters bind their input through BindAxis/BindAction, which filters the live input and keeps
+ * the handlers that replayed action events are sent to.
+ */
+UCLASS()
+class PP_TERM4_API UInputReplaySubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	static UInputReplaySubsystem* Get(const UObject* WorldContextObject);
+
+	// Seed for the random streams of the world (recorded, replayed, or random when neither)
+	static int32 GetRandomSeed(const UObject* WorldContextObject);
+
+	bool IsRecording() const { return Mode == EMode::Record; }
+	bool IsReplaying() const { return Mode == EMode::Replay; }
+
+	// Binds the axis, its value is recorded or replaced by the replayed value
+	template<class UserClass, class MethodClass>
+	void BindAxis(UInputComponent* InputComponent, FName AxisName, UserClass* Object, void (MethodClass::*Func)(float))
+	{
+		const int32 Channel = GetAxisChannel(AxisName);
+
+		if (Channel == INDEX_NONE)
+		{
+			InputComponent->BindAxis(AxisName, Object, Func);
+			return;
+		}
+
+		InputComponent->BindAxis(AxisName).AxisDelegate.GetDelegateForManualSet().BindWeakLambda(Object, [this, Channel, Object, Func](float Value)
+		{
+			(Object->*Func)(FilterAxis(Channel, Value));
+		});
+	}
+
+	// Binds the action, its events are recorded or replaced by the replayed events
+	template<class UserClass, class MethodClass>
+	void BindAction(UInputComponent* InputComponent, FName ActionName, EInputEvent KeyEvent, UserClass* Object, void (MethodClass::*Func)())
+	{
+		const int32 Action = GetActionId(ActionName, KeyEvent);
+
+		if (Action == INDEX_NONE)
+		{
+			InputComponent->BindAction(ActionName, KeyEvent, Object, Func);
+			return;
+		}
+
+		FInputActionBinding Binding(ActionName, KeyEvent);
+		Binding.ActionDelegate.GetDelegateForManualSet().BindWeakLambda(Object, [this, Action, Object, Func]()
+		{
+			if (FilterAction(Action))
+				(Object->*Func)();
+		});
+
+		InputComponent->AddActionBinding(Binding);
+
+		// Replayed events go to the pawn that bound its input last (the possessed one)
+		ActionHandlers[Action] = FSimpleDelegate::CreateWeakLambda(Object, [Object, Func]()
+		{
+			(Object->*Func)();
+		});
+	}
+
+private:
+	enum class EMode : uint8
+	{
+		None,
+		Record,
+		Replay
+	};
+
+	// Channel of a recorded axis, and id of a recorded action event (INDEX_NONE when it isn't recorded)
+	static int32 GetAxisChannel(FName AxisName);
+	static int32 GetActionId(FName ActionName, EInputEvent KeyEvent);
+	static FString GetRecordingPath(const FString& Name);
+
+	float FilterAxis(int32 Channel, float Value);
+	bool FilterAction(int32 Action);
+
+	void OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	void BeginSegment(UWorld* World);
+	void EndSegment();
+
+	// Writes the input of the frame that ended to the segment
+	void CommitFrame();
+
+	// Reads the input of the next frame from the segment and sends its action events
+	void ReplayFrame();
+
+	// Releases the replayed axes and reads no more frames of the segment
+	void StopReplayInput();
+
+	bool WriteRecording();
+	bool ReadRecording();
+
+	EMode Mode;
+	FString RecordingPath;
+	float FixedDeltaTime;
+
+	TArray<FInputReplaySegment> Segments;
+	int32 SegmentIndex;
+
+	// World of the current segment
+	TWeakObjectPtr<UWorld> SegmentWorld;
+
+	// Input of the current frame
+	TArray<float> AxisValues;
+	TArray<float> CommittedAxisValues;
+	TArray<uint8> ActionEvents;
+
+	// The current frame still has to be committed
+	bool bFrameOpen;
+
+	// Replay position in the current segment
+	int32 ReadOffset;
+	int32 ReadFrame;
+
+	TArray<FSimpleDelegate> ActionHandlers;
+
+	FDelegateHandle WorldTickStartHandle;
+};
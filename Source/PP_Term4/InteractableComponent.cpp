@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InteractableComponent.h"
+
+// Sets default values for this component's properties
+UInteractableComponent::UInteractableComponent()
+{
+	// Only holds data, so it never has to tick
+	PrimaryComponentTick.bCanEverTick = false;
+
+	InteractionType = EInteractionType::None;
+}
+
+// Called when the game starts
+void UInteractableComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	GetWorld()->GetSubsystem<UInteractionSubsystem>()->SetInteractionType(GetOwner(), InteractionType);
+}
+
+// Called when the game ends or the owner is destroyed
+void UInteractableComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UInteractionSubsystem* InteractionSubsystem = GetWorld()->GetSubsystem<UInteractionSubsystem>())
+		InteractionSubsystem->ClearInteractionType(GetOwner());
+
+	Super::EndPlay(EndPlayReason);
+}
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+
+#include "InteractionSubsystem.h"
+
+#include "InteractableComponent.generated.h"
+
+/**
+ * Marks the owner as something the player characters interact with.
+ * Takes precedence over the legacy actor tags.
+ */
+UCLASS(ClassGroup = (TheLab), meta = (BlueprintSpawnableComponent))
+class PP_TERM4_API UInteractableComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UInteractableComponent();
+
+protected:
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called when the game ends or the owner is destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Interaction")
+		EInteractionType InteractionType;
+};
@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InteractionSubsystem.h"
+#include "TheLabCollision.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+void UInteractionSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Actors with an interactable component apply their profile when they begin play, the tagged ones are resolved here
+	for (TActorIterator<AActor> It(&InWorld); It; ++It)
+	{
+		if (It->Tags.Num() > 0)
+			FTheLabCollision::ApplyInteractableProfile(*It, GetInteractionType(*It));
+	}
+
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UInteractionSubsystem::OnActorSpawned));
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UInteractionSubsystem::OnLevelAdded);
+}
+
+void UInteractionSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+
+	Types.Empty();
+
+	Super::Deinitialize();
+}
+
+EInteractionType UInteractionSubsystem::GetInteractionType(AActor* Actor)
+{
+	if (!Actor)
+		return EInteractionType::None;
+
+	if (const EInteractionType* Type = Types.Find(Actor))
+		return *Type;
+
+	// First time this actor is seen, resolve it once. Actors that aren't interactable aren't kept, resolving them is
+	// cheap (they seldom have tags) and everything that overlaps or spawns would pile up in the map otherwise
+	const EInteractionType Type = ResolveFromTags(Actor);
+	if (Type != EInteractionType::None)
+		Track(Actor, Type);
+
+	return Type;
+}
+
+void UInteractionSubsystem::SetInteractionType(AActor* Actor, EInteractionType Type)
+{
+	if (!Actor)
+		return;
+
+	Track(Actor, Type);
+	FTheLabCollision::ApplyInteractableProfile(Actor, Type);
+}
+
+void UInteractionSubsystem::ClearInteractionType(AActor* Actor)
+{
+	if (!Actor)
+		return;
+
+	Actor->OnEndPlay.RemoveDynamic(this, &UInteractionSubsystem::OnActorEndPlay);
+	Types.Remove(Actor);
+}
+
+void UInteractionSubsystem::RecordOverlapCallback(bool bInteractable)
+{
+	NumOverlapCallbacks++;
+
+	if (!bInteractable)
+		NumIgnoredOverlapCallbacks++;
+}
+
+void UInteractionSubsystem::ResetOverlapCallbacks()
+{
+	NumOverlapCallbacks = 0;
+	NumIgnoredOverlapCallbacks = 0;
+}
+
+void UInteractionSubsystem::OnActorSpawned(AActor* Actor)
+{
+	// Pooled recharges and generated coins (an interactable component applies the profile itself)
+	if (Actor && Actor->Tags.Num() > 0)
+		FTheLabCollision::ApplyInteractableProfile(Actor, GetInteractionType(Actor));
+}
+
+void UInteractionSubsystem::OnActorEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	Types.Remove(Actor);
+}
+
+void UInteractionSubsystem::Track(AActor* Actor, EInteractionType Type)
+{
+	// Dropped again when the actor is destroyed or its level streams out
+	Actor->OnEndPlay.AddUniqueDynamic(this, &UInteractionSubsystem::OnActorEndPlay);
+	Types.Add(Actor, Type);
+}
+
+void UInteractionSubsystem::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	// The delegate is global, other worlds (the editor, PIE clients) stream their own levels
+	if (!Level || World != GetWorld())
+		return;
+
+	for (AActor* Actor : Level->Actors)
+	{
+		if (Actor && Actor->Tags.Num() > 0)
+			FTheLabCollision::ApplyInteractableProfile(Actor, GetInteractionType(Actor));
+	}
+}
+
+EInteractionType UInteractionSubsystem::ResolveFromTags(const AActor* Actor)
+{
+	// Legacy tags and the type they stand for
+	static const TPair<FName, EInteractionType> TagTypes[] =
+	{
+		{ FName(TEXT("Coin")), EInteractionType::Coin },
+		{ FName(TEXT("Recharge")), EInteractionType::Recharge },
+		{ FName(TEXT("Game1")), EInteractionType::Game1 },
+		{ FName(TEXT("Game2")), EInteractionType::Game2 },
+		{ FName(TEXT("End")), EInteractionType::End }
+	};
+
+	for (const FName& Tag : Actor->Tags)
+	{
+		for (const TPair<FName, EInteractionType>& TagType : TagTypes)
+		{
+			if (Tag == TagType.Key)
+				return TagType.Value;
+		}
+	}
+
+	return EInteractionType::None;
+}
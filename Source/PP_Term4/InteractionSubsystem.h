@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameFramework/Actor.h"
+
+#include "InteractionSubsystem.generated.h"
+
+// What the player can do with an actor it touches
+UENUM(BlueprintType)
+enum class EInteractionType : uint8
+{
+	None,
+	Coin,
+	Recharge,
+	Game1,
+	Game2,
+	End,
+
+	MAX UMETA(Hidden)
+};
+
+/**
+ * Resolves and caches the interaction type of actors, so an overlap handler
+ * costs one map lookup instead of a chain of ActorHasTag scans.
+ * The type comes from an UInteractableComponent, or from the legacy actor tags
+ * ("Coin", "Recharge", "Game1", "Game2", "End") the first time the actor is seen.
+ * Interactables are put on the collision profile of their type (see FTheLabCollision) when they begin play, spawn
+ * or their level is streamed in.
+ */
+UCLASS()
+class PP_TERM4_API UInteractionSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	EInteractionType GetInteractionType(AActor* Actor);
+
+	void SetInteractionType(AActor* Actor, EInteractionType Type);
+	void ClearInteractionType(AActor* Actor);
+
+	// Counts an overlap callback of a player character (bInteractable is false for actors it doesn't interact with)
+	void RecordOverlapCallback(bool bInteractable);
+	void ResetOverlapCallbacks();
+
+	// Callbacks since the last reset
+	int32 GetNumOverlapCallbacks() const { return NumOverlapCallbacks; }
+	int32 GetNumIgnoredOverlapCallbacks() const { return NumIgnoredOverlapCallbacks; }
+
+private:
+	static EInteractionType ResolveFromTags(const AActor* Actor);
+
+	// Applies the collision profile to tagged actors that spawn during play
+	void OnActorSpawned(AActor* Actor);
+
+	// Applies the collision profile to the tagged actors of a streamed level (loading it doesn't spawn them)
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+
+	UFUNCTION()
+		void OnActorEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+
+	void Track(AActor* Actor, EInteractionType Type);
+
+	// Resolved types of the interactables in play
+	TMap<TObjectKey<AActor>, EInteractionType> Types;
+
+	FDelegateHandle ActorSpawnedHandle;
+	FDelegateHandle LevelAddedHandle;
+
+	int32 NumOverlapCallbacks = 0;
+	int32 NumIgnoredOverlapCallbacks = 0;
+};
@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LevelTransitionSubsystem.h"
+#include "PP_Term4.h"
+#include "ScreenFadeSubsystem.h"
+#include "TheLabStats.h"
+#include "Engine/Level.h"
+#include "Engine/LevelStreamingDynamic.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+
+static TAutoConsoleVariable<bool> CVarUseLevelStreaming(
+	TEXT("thelab.Levels.UseStreaming"),
+	false,
+	TEXT("Stream Game2 into the hub instead of opening its map (off by default, Game1 is always opened)."));
+
+static TAutoConsoleVariable<float> CVarStreamedGameDepth(
+	TEXT("thelab.Levels.StreamedGameDepth"),
+	-100000.0f,
+	TEXT("Height offset of streamed mini-games, keeps them out of sight of the hub."));
+
+// Map of the hub and the folder of the maps
+static const FName HubMap(TEXT("ThirdPersonMap_2"));
+static const TCHAR* MapFolder = TEXT("/Game/Levels/");
+
+// Mini-games that need their own game mode are always opened: the recharges of Game1 are spawned by its game mode and its
+// round needs the CollectPlayerState of that game mode, neither exists in the hub (and the spawn bounds are world coordinates)
+static const FName OpenedGameMaps[] = { FName(TEXT("Game1")) };
+
+void ULevelTransitionSubsystem::TravelToGame(FName GameMap)
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_LevelTransition);
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+
+	const bool bCanStream = !MakeArrayView(OpenedGameMaps).Contains(GameMap);
+
+	if (CVarUseLevelStreaming.GetValueOnGameThread() && !bCanStream)
+		UE_LOG(LogTheLab, Log, TEXT("%s can't be streamed, opening it"), *GameMap.ToString());
+
+	if (!CVarUseLevelStreaming.GetValueOnGameThread() || !bCanStream || !PlayerController || ActiveGameLevel || GetWorld()->GetNetMode() != NM_Standalone)
+	{
+		OpenMap(GameMap);
+		return;
+	}
+
+	TransitionStartTime = FPlatformTime::Seconds();
+
+	bool bSuccess = false;
+	const FVector Offset(0.0f, 0.0f, CVarStreamedGameDepth.GetValueOnGameThread());
+
+	ULevelStreamingDynamic* GameLevel = ULevelStreamingDynamic::LoadLevelInstance(this, FString(MapFolder) + GameMap.ToString(), Offset, FRotator::ZeroRotator, bSuccess);
+
+	if (!bSuccess || !GameLevel)
+	{
+		UE_LOG(LogTheLab, Warning, TEXT("Couldn't stream %s, opening it instead"), *GameMap.ToString());
+		OpenMap(GameMap);
+		return;
+	}
+
+	ActiveGameLevel = GameLevel;
+	ActiveGameMap = GameMap;
+
+	// A restart unpossessed the mini-game pawn and streams the map again, the parked hub pawn stays the same
+	if (APawn* Pawn = PlayerController->GetPawn())
+		HubPawn = Pawn;
+
+	ActiveGameLevel->OnLevelShown.AddDynamic(this, &ULevelTransitionSubsystem::OnGameLevelShown);
+}
+
+void ULevelTransitionSubsystem::ReturnToHub(bool bWon)
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_LevelTransition);
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	APawn* Pawn = HubPawn.Get();
+
+	if (!ActiveGameLevel || !PlayerController || !Pawn)
+	{
+		OpenMap(HubMap);
+		return;
+	}
+
+	const FName GameMap = ActiveGameMap;
+
+	UnloadGameLevel();
+
+	// Take control of the hub pawn again, it kept its state while the mini-game was played
+	Pawn->SetActorHiddenInGame(false);
+	Pawn->SetActorEnableCollision(true);
+	Pawn->SetActorTickEnabled(Pawn->PrimaryActorTick.bStartWithTickEnabled);
+
+	PlayerController->Possess(Pawn);
+	PlayerController->SetViewTarget(Pawn);
+
+	// The screen was faded out to leave the mini-game
+	GetWorld()->GetSubsystem<UScreenFadeSubsystem>()->FadeIn();
+
+	OnReturnedToHub.Broadcast(GameMap, bWon);
+}
+
+void ULevelTransitionSubsystem::RestartGame()
+{
+	if (!ActiveGameLevel)
+	{
+		OpenMap(FName(*GetWorld()->GetName()), false);
+		return;
+	}
+
+	// Stream in a fresh instance of the same map
+	const FName GameMap = ActiveGameMap;
+
+	UnloadGameLevel();
+	TravelToGame(GameMap);
+}
+
+void ULevelTransitionSubsystem::OnGameLevelShown()
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_LevelTransition);
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	ULevel* Level = ActiveGameLevel ? ActiveGameLevel->GetLoadedLevel() : nullptr;
+
+	if (!PlayerController || !Level)
+		return;
+
+	// The pawn of the mini-game is the one that is placed to be possessed by the player
+	APawn* GamePawn = nullptr;
+
+	for (AActor* Actor : Level->Actors)
+	{
+		APawn* Pawn = Cast<APawn>(Actor);
+
+		if (Pawn && Pawn->AutoPossessPlayer != EAutoReceiveInput::Disabled)
+		{
+			GamePawn = Pawn;
+			break;
+		}
+	}
+
+	if (!GamePawn)
+	{
+		// Mini-games whose pawn is spawned by their game mode can only be opened
+		UE_LOG(LogTheLab, Warning, TEXT("Streamed %s has no placed pawn for the player, opening it instead"), *ActiveGameMap.ToString());
+
+		const FName GameMap = ActiveGameMap;
+		UnloadGameLevel();
+		OpenMap(GameMap);
+		return;
+	}
+
+	// Park the hub pawn
+	if (APawn* Pawn = HubPawn.Get())
+	{
+		Pawn->SetActorHiddenInGame(true);
+		Pawn->SetActorEnableCollision(false);
+		Pawn->SetActorTickEnabled(false);
+	}
+
+	PlayerController->Possess(GamePawn);
+	PlayerController->SetViewTarget(GamePawn);
+
+	GetWorld()->GetSubsystem<UScreenFadeSubsystem>()->FadeIn();
+
+	UE_LOG(LogTheLab, Log, TEXT("Streamed in %s in %.1f ms"), *ActiveGameMap.ToString(), (FPlatformTime::Seconds() - TransitionStartTime) * 1000.0);
+}
+
+void ULevelTransitionSubsystem::UnloadGameLevel()
+{
+	if (!ActiveGameLevel)
+		return;
+
+	// Release the mini-game pawn before its level goes away
+	if (APlayerController* PlayerController = GetWorld()->GetFirstPlayerController())
+		PlayerController->UnPossess();
+
+	ActiveGameLevel->OnLevelShown.RemoveAll(this);
+	ActiveGameLevel->SetShouldBeVisible(false);
+	ActiveGameLevel->SetShouldBeLoaded(false);
+	ActiveGameLevel->SetIsRequestingUnloadAndRemoval(true);
+
+	ActiveGameLevel = nullptr;
+	ActiveGameMap = NAME_None;
+}
+
+void ULevelTransitionSubsystem::OpenMap(FName Map, bool bAbsolute)
+{
+	UWorld* World = GetWorld();
+
+	switch (World->GetNetMode())
+	{
+	case NM_Standalone:
+		UGameplayStatics::OpenLevel(this, Map, bAbsolute);
+		break;
+
+	case NM_Client:
+		// Opening a map would leave the server, the client follows the travel of the server instead
+		UE_LOG(LogTheLab, Verbose, TEXT("Ignoring the travel of a client to %s"), *Map.ToString());
+		break;
+
+	default:
+		// Keep listening, the clients travel with the server
+		World->ServerTravel(FString(MapFolder) + Map.ToString() + (World->GetNetMode() == NM_ListenServer ? TEXT("?listen") : TEXT("")));
+		break;
+	}
+}
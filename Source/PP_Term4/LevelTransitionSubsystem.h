@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameFramework/Pawn.h"
+
+#include "LevelTransitionSubsystem.generated.h"
+
+class ULevelStreamingDynamic;
+
+// Called in the hub when the player comes back from a mini-game
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnReturnedToHub, FName /*GameMap*/, bool /*bWon*/);
+
+/**
+ * Moves the player between the hub and the mini-games.
+ * By default every transition is a full OpenLevel. With thelab.Levels.UseStreaming the hub stays loaded
+ * as the persistent level, and Game2 is streamed in as a level instance below it:
+ * the player is teleported by possessing the mini-game pawn, and the hub pawn keeps its state.
+ * Game1 is always opened, its recharges and player state come from its own game mode, so only Game2 can be streamed.
+ * In a networked game only the server changes the level, with a server travel the clients follow, and a client's own
+ * requests are ignored (the mini-games are only streamed in a standalone game).
+ */
+UCLASS()
+class PP_TERM4_API ULevelTransitionSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Opens or streams in the mini-game map
+	void TravelToGame(FName GameMap);
+
+	// Goes back to the hub (streamed mini-games are unloaded, otherwise the hub map is opened)
+	void ReturnToHub(bool bWon);
+
+	// Starts the current mini-game again
+	void RestartGame();
+
+	// Returns true when the current mini-game is streamed into the hub
+	bool IsGameStreamed() const { return ActiveGameLevel != nullptr; }
+
+	FOnReturnedToHub OnReturnedToHub;
+
+private:
+	UFUNCTION()
+		void OnGameLevelShown();
+
+	void UnloadGameLevel();
+
+	// Opens the map, or travels the server and its clients to it in a networked game
+	void OpenMap(FName Map, bool bAbsolute = true);
+
+	// Mini-game that is streamed in
+	UPROPERTY()
+		ULevelStreamingDynamic* ActiveGameLevel;
+
+	FName ActiveGameMap;
+
+	// Pawn the player controls in the hub
+	TWeakObjectPtr<APawn> HubPawn;
+
+	// When the current transition started
+	double TransitionStartTime;
+};
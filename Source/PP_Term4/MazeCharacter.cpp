@@ -1,256 +1,437 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-
-#include "MazeCharacter.h"
-
-// Sets default values
-AMazeCharacter::AMazeCharacter()
-{
-	// Set this character to call Tick() every frame. You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
-
-	// Set the size of the capsule
-	GetCapsuleComponent()->InitCapsuleSize(42.0f, 96.0f);
-
-	// Turns off the rotattion of the player (so that only camera moves)
-	bUseControllerRotationPitch = false;
-	bUseControllerRotationYaw = false;
-	bUseControllerRotationRoll = false;
-
-	GetCharacterMovement()->bOrientRotationToMovement = true;									// Allows the character movement to rotate in the direction it is moving
-	GetCharacterMovement()->RotationRate = FRotator(0.0f, 540.0f, 0.0f) * GetActorScale3D().X;	// The rate that is used for the rotation
-	GetCharacterMovement()->JumpZVelocity = 600.0f;												// Velocity when the player jumps
-	GetCharacterMovement()->AirControl = 0.2f;													// Control of the player in the air
-
-	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));				// Create cameraboom (springarm)
-	CameraBoom->SetupAttachment(RootComponent);													// Set it as a child of the capsule
-
-	CameraBoom->TargetArmLength = CameraBoom->TargetArmLength;									// How far the spring arm (camera) will be from the player
-	CameraBoom->bUsePawnControlRotation = true;													// Rotate the arm based on the controller
-
-	FollowCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));				// Create camera
-	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);					// Link the camera to the end of the springboom
-	FollowCamera->bUsePawnControlRotation = false;												// The camera doesn't rotate relative to the arm
-
-	// Set variables
-	pDead = false;
-	SprintSpeedMultiplier = 2.0f;
-}
-
-// Called when the game starts or when spawned
-void AMazeCharacter::BeginPlay()
-{
-	Super::BeginPlay();
-
-	// Set the max walk speed of the character to the given max walk speed
-	GetCharacterMovement()->MaxWalkSpeed = pMaxWalkSpeed;
-
-	// Add the overlap event to the function
-	GetCapsuleComponent()->OnComponentBeginOverlap.AddDynamic(this, &AMazeCharacter::OnBeginOverlap);
-
-	// Add the UI
-	if (Player_Collect_Widget_Class)
-	{
-		Player_Collect_Widget = CreateWidget(GetWorld(), Player_Collect_Widget_Class);
-		Player_Collect_Widget->AddToViewport();
-	}
-
-	timer = startTimer;
-}
-
-// Called every frame
-void AMazeCharacter::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-
-	if (collectedCoins >= coinsToCollect)
-	{
-		if (Player_Won_Widget_Class)
-		{
-			Player_Won_Widget = CreateWidget(GetWorld(), Player_Won_Widget_Class);
-			Player_Won_Widget->AddToViewport();
-
-			FTimerHandle localHandler;
-			GetWorldTimerManager().SetTimer(localHandler, this, &AMazeCharacter::CallFadeOut_Won, 3.0f, false);
-		}
-	}
-	else
-		HandleTimer(DeltaTime);
-}
-
-// Called to bind functionality to input
-void AMazeCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
-{
-	Super::SetupPlayerInputComponent(PlayerInputComponent);
-
-	// Combine the axis to the function (executes when pressed)
-	PlayerInputComponent->BindAxis("Move Forward / Backward", this, &AMazeCharacter::MoveForward);
-	PlayerInputComponent->BindAxis("Move Right / Left", this, &AMazeCharacter::MoveRight);
-
-	PlayerInputComponent->BindAction("Sprint", IE_Pressed, this, &AMazeCharacter::Sprint);
-	PlayerInputComponent->BindAction("Sprint", IE_Released, this, &AMazeCharacter::StopSprinting);
-
-
-	// Combine the wheel axis to the camera move function
-	PlayerInputComponent->BindAxis("Wheel", this, &AMazeCharacter::MoveCamera);
-}
-
-#pragma region Movement
-
-void AMazeCharacter::MoveForward(float Axis)
-{
-	if (!pDead)
-	{
-		const FRotator Rotation = Controller->GetControlRotation();
-		const FRotator YawRotation(0, Rotation.Yaw, 0);
-
-		// Calculate the forward direction vector
-		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X);
-		AddMovementInput(Direction, Axis);
-	}
-}
-
-void AMazeCharacter::MoveRight(float Axis)
-{
-	if (!pDead)
-	{
-		const FRotator Rotation = Controller->GetControlRotation();
-		const FRotator YawRotation(0, Rotation.Yaw, 0);
-
-		// Calculate the right direction vector
-		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y);
-		AddMovementInput(Direction, Axis);
-	}
-}
-
-void AMazeCharacter::Sprint()
-{
-	if (!pDead)
-		GetCharacterMovement()->MaxWalkSpeed = pMaxWalkSpeed * SprintSpeedMultiplier;
-}
-
-void AMazeCharacter::StopSprinting()
-{
-	GetCharacterMovement()->MaxWalkSpeed = pMaxWalkSpeed;
-}
-
-void AMazeCharacter::MoveCamera(float Axis)
-{
-	if (!pDead)
-	{
-		if (Axis == -1 && CameraBoom->TargetArmLength < 1000.0f)
-			CameraBoom->TargetArmLength += 20.0f;
-		else if (Axis == 1 && CameraBoom->TargetArmLength > 200.0f)
-			CameraBoom->TargetArmLength -= 20.0f;
-	}
-}
-
-#pragma endregion
-
-#pragma region Overlap
-
-void AMazeCharacter::OnBeginOverlap(UPrimitiveComponent* HitComponent,
-	AActor* OtherActor, UPrimitiveComponent* OtherComponent, int32 OtherBodyIndex,
-	bool bFromSweep, const FHitResult& SweepResult)
-{
-	if (OtherActor->ActorHasTag("Coin"))
-	{
-		collectedCoins++;
-		OtherActor->Destroy();
-
-		// Spawn particle
-		if (PickingUpCoinEffect)
-			UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), PickingUpCoinEffect, GetActorLocation());
-	}
-}
-
-void AMazeCharacter::OnEndOverlap(class UPrimitiveComponent* OverlappedComp,
-	class AActor* OtherActor, class UPrimitiveComponent* OtherComp,
-	int32 OtherBodyIndex)
-{
-
-}
-
-#pragma endregion
-
-#pragma region Handler
-
-void AMazeCharacter::HandleTimer(float pMinusAmount)
-{
-	if (!pDead)
-	{
-		if (timer > 0)
-			timer -= pMinusAmount;
-		else if (timer <= 0)
-		{
-			timer = 0;
-
-			if (!pDead)
-			{
-				pDead = true;
-				GetMesh()->SetSimulatePhysics(true);
-
-				if (Player_Lost_Widget_Class)
-				{
-					Player_Lost_Widget = CreateWidget(GetWorld(), Player_Lost_Widget_Class);
-					Player_Lost_Widget->AddToViewport();
-				}
-
-				FTimerHandle localHandler;
-				GetWorldTimerManager().SetTimer(localHandler, this, &AMazeCharacter::CallFadeOut_Lost, 3.0f, false);
-			}
-		}
-	}
-}
-
-#pragma endregion
-
-#pragma region Callers / Level Switchers / Data Savers
-
-void AMazeCharacter::CallFadeOut_Won()
-{
-	FOutputDeviceNull argument;
-	const FString command = FString::Printf(TEXT("SetFadeOut true"));
-
-	if (blueprintActor)
-		blueprintActor->CallFunctionByNameWithArguments(*command, argument, NULL, true);
-
-	level2Won = true;
-	CallSaveGameVariables();
-
-	FTimerHandle localHandler;
-	GetWorldTimerManager().SetTimer(localHandler, this, &AMazeCharacter::ToMainLevel, 0.83f, false);
-}
-
-void AMazeCharacter::CallFadeOut_Lost()
-{
-	FOutputDeviceNull argument;
-	const FString command = FString::Printf(TEXT("SetFadeOut true"));
-
-	if (blueprintActor)
-		blueprintActor->CallFunctionByNameWithArguments(*command, argument, NULL, true);
-
-	FTimerHandle localHandler;
-	GetWorldTimerManager().SetTimer(localHandler, this, &AMazeCharacter::RestartGame, 0.83f, false);
-}
-
-void AMazeCharacter::ToMainLevel()
-{
-	UGameplayStatics::OpenLevel(this, "ThirdPersonMap_2");
-}
-
-void AMazeCharacter::RestartGame()
-{
-	UGameplayStatics::OpenLevel(this, FName(*GetWorld()->GetName()), false);
-}
-
-void AMazeCharacter::CallSaveGameVariables()
-{
-	FOutputDeviceNull argument;
-	const FString command = FString::Printf(TEXT("SaveGame Slot1"));
-
-	if (blueprintActor)
-		blueprintActor->CallFunctionByNameWithArguments(*command, argument, NULL, true);
-}
-
-#pragma endregion
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MazeCharacter.h"
+#include "CoinFieldComponent.h"
+#include "MazeGenerator.h"
+#include "TheLabCollision.h"
+#include "TheLabStats.h"
+#include "EngineUtils.h"
+
+// Sets default values
+AMazeCharacter::AMazeCharacter()
+{
+	// The round is event driven, so this character doesn't need to tick
+	PrimaryActorTick.bCanEverTick = false;
+
+	// Set the size of the capsule
+	GetCapsuleComponent()->InitCapsuleSize(42.0f, 96.0f);
+
+	// Turns off the rotattion of the player (so that only camera moves)
+	bUseControllerRotationPitch = false;
+	bUseControllerRotationYaw = false;
+	bUseControllerRotationRoll = false;
+
+	GetCharacterMovement()->bOrientRotationToMovement = true;									// Allows the character movement to rotate in the direction it is moving
+	GetCharacterMovement()->RotationRate = FRotator(0.0f, 540.0f, 0.0f) * GetActorScale3D().X;	// The rate that is used for the rotation
+	GetCharacterMovement()->JumpZVelocity = 600.0f;												// Velocity when the player jumps
+	GetCharacterMovement()->AirControl = 0.2f;													// Control of the player in the air
+
+	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));				// Create cameraboom (springarm)
+	CameraBoom->SetupAttachment(RootComponent);													// Set it as a child of the capsule
+
+	CameraBoom->TargetArmLength = CameraBoom->TargetArmLength;									// How far the spring arm (camera) will be from the player
+	CameraBoom->bUsePawnControlRotation = true;													// Rotate the arm based on the controller
+
+	FollowCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));				// Create camera
+	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);					// Link the camera to the end of the springboom
+	FollowCamera->bUsePawnControlRotation = false;												// The camera doesn't rotate relative to the arm
+
+	RoundState = CreateDefaultSubobject<URoundStateComponent>(TEXT("RoundState"));				// Create the round state
+	HUDData = CreateDefaultSubobject<UHUDDataComponent>(TEXT("HUDData"));						// Create the values of the HUD
+
+	// Set variables
+	pDead = false;
+	InteractionSubsystem = nullptr;
+	HUDWidgets = nullptr;
+	RoundReset = nullptr;
+	GhostRace = nullptr;
+	MazeLayoutSeed = 0;
+	MazeSize = FIntPoint::ZeroValue;
+	SprintSpeedMultiplier = 2.0f;
+}
+
+// Called when the game starts or when spawned
+void AMazeCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Set the max walk speed of the character to the given max walk speed
+	GetCharacterMovement()->MaxWalkSpeed = pMaxWalkSpeed;
+
+	// Only overlap the interactables, and add the overlap event to the function
+	FTheLabCollision::ApplyCharacterProfile(this);
+	GetCapsuleComponent()->OnComponentBeginOverlap.AddDynamic(this, &AMazeCharacter::OnBeginOverlap);
+
+	// Cache the interaction lookup used by the overlap events
+	InteractionSubsystem = GetWorld()->GetSubsystem<UInteractionSubsystem>();
+
+	// Let the pickup registry collect the pickups when it replaces the overlap events
+	UPickupRegistrySubsystem* PickupRegistry = GetWorld()->GetSubsystem<UPickupRegistrySubsystem>();
+
+	if (PickupRegistry && PickupRegistry->IsActive())
+		PickupRegistry->SetCollector(this, FOnPickupCollected::CreateUObject(this, &AMazeCharacter::Interact));
+
+	// Create the pickup effects once the particles are loaded, so collecting doesn't create components
+	FeedbackEffects = GetWorld()->GetSubsystem<UFeedbackEffectsSubsystem>();
+
+	UAssetPreloadSubsystem* AssetPreload = UAssetPreloadSubsystem::Get(this);
+	PickupAssets = AssetPreload->Preload({ PickingUpCoinEffect.ToSoftObjectPath() }, FOnAssetsPreloaded::CreateUObject(this, &AMazeCharacter::OnPickupAssetsLoaded), true);
+
+	// Load the UI in the background, the HUD is needed right away and the end of round UI only in a while
+	HUDWidgets = UHUDWidgetSubsystem::Get(this);
+
+	if (HUDWidgets)
+	{
+		HUDAssets = AssetPreload->Preload({ Player_Collect_Widget_Class.ToSoftObjectPath() }, FOnAssetsPreloaded::CreateUObject(this, &AMazeCharacter::OnHUDAssetsLoaded), true);
+		RoundEndAssets = AssetPreload->Preload({ Player_Won_Widget_Class.ToSoftObjectPath(), Player_Lost_Widget_Class.ToSoftObjectPath() }, FOnAssetsPreloaded::CreateUObject(this, &AMazeCharacter::OnRoundEndAssetsLoaded));
+	}
+
+	// Read the saved progress
+	if (UProgressSaveSubsystem* ProgressSave = UProgressSaveSubsystem::Get(this))
+	{
+		level1Won |= ProgressSave->IsGameWon("Game1");
+		level2Won |= ProgressSave->IsGameWon("Game2");
+	}
+
+	// A generated maze places the coins, so the target is what it actually placed
+	for (TActorIterator<AMazeGenerator> It(GetWorld()); It; ++It)
+	{
+		It->EnsureGenerated();
+		coinsToCollect = It->GetNumPlacedCoins();
+		MazeLayoutSeed = It->GetLayoutSeed();
+		MazeSize = It->GetSize();
+		break;
+	}
+
+	// Remember the start of the round for a retry (after the maze, so the generated coins are part of it)
+	RoundReset = GetWorld()->GetSubsystem<URoundResetSubsystem>();
+	RoundReset->Capture(this);
+
+	GhostRace = UGhostRaceSubsystem::Get(this);
+
+	RoundState->OnStateChanged.AddUObject(this, &AMazeCharacter::OnRoundStateChanged);
+	StartRound();
+}
+
+// Called when the character is destroyed or its level is unloaded
+void AMazeCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// The widget pool outlives a streamed mini-game, so its UI has to leave with the character
+	if (UHUDWidgetSubsystem* WidgetPool = UHUDWidgetSubsystem::Get(this))
+	{
+		WidgetPool->Release(Player_Collect_Widget_Class.Get());
+		WidgetPool->Release(Player_Won_Widget_Class.Get());
+		WidgetPool->Release(Player_Lost_Widget_Class.Get());
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Called to bind functionality to input
+void AMazeCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
+{
+	Super::SetupPlayerInputComponent(PlayerInputComponent);
+
+	// The input goes through the replay subsystem, so it can be recorded and replayed
+	UInputReplaySubsystem* InputReplay = UInputReplaySubsystem::Get(this);
+
+	// Combine the axis to the function (executes when pressed)
+	InputReplay->BindAxis(PlayerInputComponent, "Move Forward / Backward", this, &AMazeCharacter::MoveForward);
+	InputReplay->BindAxis(PlayerInputComponent, "Move Right / Left", this, &AMazeCharacter::MoveRight);
+
+	InputReplay->BindAction(PlayerInputComponent, "Sprint", IE_Pressed, this, &AMazeCharacter::Sprint);
+	InputReplay->BindAction(PlayerInputComponent, "Sprint", IE_Released, this, &AMazeCharacter::StopSprinting);
+
+
+	// Combine the wheel axis to the camera move function
+	InputReplay->BindAxis(PlayerInputComponent, "Wheel", this, &AMazeCharacter::MoveCamera);
+}
+
+#pragma region Movement
+
+void AMazeCharacter::MoveForward(float Axis)
+{
+	if (!pDead)
+		MovementInput.AddForward(Axis);
+}
+
+void AMazeCharacter::MoveRight(float Axis)
+{
+	if (!pDead)
+		MovementInput.AddRight(Axis);
+
+	// Bound after MoveForward, so this is the last movement axis of the frame
+	MovementInput.Flush(this);
+}
+
+void AMazeCharacter::Sprint()
+{
+	if (!pDead)
+		GetCharacterMovement()->MaxWalkSpeed = pMaxWalkSpeed * SprintSpeedMultiplier;
+}
+
+void AMazeCharacter::StopSprinting()
+{
+	GetCharacterMovement()->MaxWalkSpeed = pMaxWalkSpeed;
+}
+
+void AMazeCharacter::MoveCamera(float Axis)
+{
+	if (!pDead)
+	{
+		if (Axis == -1 && CameraBoom->TargetArmLength < 1000.0f)
+			CameraBoom->TargetArmLength += 20.0f;
+		else if (Axis == 1 && CameraBoom->TargetArmLength > 200.0f)
+			CameraBoom->TargetArmLength -= 20.0f;
+	}
+}
+
+#pragma endregion
+
+#pragma region Overlap
+
+void AMazeCharacter::OnBeginOverlap(UPrimitiveComponent* HitComponent,
+	AActor* OtherActor, UPrimitiveComponent* OtherComponent, int32 OtherBodyIndex,
+	bool bFromSweep, const FHitResult& SweepResult)
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_Overlap);
+
+	// The coins of a coin field are instances, the body index is the coin
+	if (UCoinFieldComponent* CoinField = Cast<UCoinFieldComponent>(OtherComponent))
+	{
+		InteractionSubsystem->RecordOverlapCallback(true);
+
+		if (CoinField->Collect(OtherBodyIndex))
+			AddCollectedCoin();
+
+		return;
+	}
+
+	const EInteractionType Type = InteractionSubsystem->GetInteractionType(OtherActor);
+	InteractionSubsystem->RecordOverlapCallback(Type != EInteractionType::None);
+
+	Interact(OtherActor, Type);
+}
+
+void AMazeCharacter::OnEndOverlap(class UPrimitiveComponent* OverlappedComp,
+	class AActor* OtherActor, class UPrimitiveComponent* OtherComp,
+	int32 OtherBodyIndex)
+{
+
+}
+
+#pragma endregion
+
+#pragma region Interactions
+
+// Interaction handlers, indexed by interaction type
+const AMazeCharacter::FInteractionHandler AMazeCharacter::InteractionHandlers[] =
+{
+	nullptr,						// None
+	&AMazeCharacter::CollectCoin,	// Coin
+	nullptr,						// Recharge
+	nullptr,						// Game1
+	nullptr,						// Game2
+	nullptr							// End
+};
+
+void AMazeCharacter::Interact(AActor* OtherActor, EInteractionType Type)
+{
+	static_assert(UE_ARRAY_COUNT(InteractionHandlers) == (uint8)EInteractionType::MAX, "Every interaction type needs an entry in InteractionHandlers");
+
+	if (const FInteractionHandler Handler = InteractionHandlers[(uint8)Type])
+		(this->*Handler)(OtherActor);
+}
+
+void AMazeCharacter::CollectCoin(AActor* Coin)
+{
+	// Coins of the snapshot are only deactivated, so a retry can bring them back
+	if (!RoundReset->Consume(Coin))
+		Coin->Destroy();
+
+	AddCollectedCoin();
+}
+
+void AMazeCharacter::AddCollectedCoin()
+{
+	collectedCoins++;
+	HUDData->SetCoins(collectedCoins, coinsToCollect);
+
+	// Play the particle and sound
+	FeedbackEffects->Play(PickingUpCoinEffect.Get(), PickingUpCoinSound, GetActorLocation());
+
+	if (collectedCoins >= coinsToCollect)
+	{
+		// Freeze the displayed timer at the moment of winning
+		RefreshDisplay();
+		RoundState->FinishRound(ERoundState::Won);
+	}
+}
+
+#pragma endregion
+
+#pragma region Handlers
+
+void AMazeCharacter::StartRound()
+{
+	// The round is lost when the timer runs out
+	collectedCoins = 0;
+	HUDData->SetCoins(collectedCoins, coinsToCollect);
+
+	RoundState->ScheduleOutcome(ERoundState::Lost, startTimer);
+	RefreshDisplay();
+
+	// Record the run, against the ghost of the best one
+	if (GhostRace)
+		GhostRace->BeginRun(this, MazeLayoutSeed, MazeSize, GhostClass);
+}
+
+void AMazeCharacter::RefreshDisplay()
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_RefreshDisplay);
+
+	timer = RoundState->GetScheduledOutcomeRemaining();
+	HUDData->SetTimeRemaining(timer);
+
+	// Refresh again when the displayed second changes
+	if (RoundState->IsPlaying())
+		GetWorldTimerManager().SetTimer(DisplayTimerHandle, this, &AMazeCharacter::RefreshDisplay, UHUDDataComponent::GetSecondsUntilDisplayChange(timer, 1.0f) + DisplayRefreshMargin, false);
+}
+
+void AMazeCharacter::OnRoundStateChanged(ERoundState OldState, ERoundState NewState)
+{
+	if (NewState == ERoundState::Won)
+	{
+		GetWorldTimerManager().ClearTimer(DisplayTimerHandle);
+
+		// A faster run becomes the new ghost
+		if (GhostRace)
+			GhostRace->EndRun(true);
+
+		// Loads the class now when its preload hasn't finished yet
+		if (HUDWidgets)
+			Player_Won_Widget = HUDWidgets->Show(Player_Won_Widget_Class.LoadSynchronous());
+
+		FTimerHandle localHandler;
+		GetWorldTimerManager().SetTimer(localHandler, this, &AMazeCharacter::CallFadeOut_Won, 3.0f, false);
+	}
+	else if (NewState == ERoundState::Lost)
+	{
+		GetWorldTimerManager().ClearTimer(DisplayTimerHandle);
+		timer = 0;
+		HUDData->SetTimeRemaining(timer);
+
+		if (GhostRace)
+			GhostRace->EndRun(false);
+
+		pDead = true;
+		GetMesh()->SetSimulatePhysics(true);
+
+		if (HUDWidgets)
+			Player_Lost_Widget = HUDWidgets->Show(Player_Lost_Widget_Class.LoadSynchronous());
+
+		FTimerHandle localHandler;
+		GetWorldTimerManager().SetTimer(localHandler, this, &AMazeCharacter::CallFadeOut_Lost, 3.0f, false);
+	}
+}
+
+void AMazeCharacter::OnPickupAssetsLoaded()
+{
+	FeedbackEffects->Prewarm(PickingUpCoinEffect.Get(), PickingUpCoinSound);
+}
+
+void AMazeCharacter::OnHUDAssetsLoaded()
+{
+	// The widget shows the values that were set while it was loading
+	Player_Collect_Widget = HUDWidgets->Show(Player_Collect_Widget_Class.Get());
+
+	if (UPlayerHUDWidget* HUDWidget = Cast<UPlayerHUDWidget>(Player_Collect_Widget))
+		HUDWidget->SetDataSource(HUDData);
+	else if (Player_Collect_Widget)
+		UE_LOG(LogTheLab, Warning, TEXT("%s isn't a PlayerHUDWidget, its property bindings poll every frame (reparent it to PlayerHUDWidget)"), *Player_Collect_Widget->GetClass()->GetName());
+}
+
+void AMazeCharacter::OnRoundEndAssetsLoaded()
+{
+	// Build the end of round UI up front so it only has to be shown
+	HUDWidgets->Prewarm(Player_Won_Widget_Class.Get());
+	HUDWidgets->Prewarm(Player_Lost_Widget_Class.Get());
+}
+
+#pragma endregion
+
+#pragma region Callers / Level Switchers / Data Savers
+
+void AMazeCharacter::CallFadeOut_Won()
+{
+	RoundState->BeginTransition();
+
+	level2Won = true;
+	CallSaveGameVariables();
+
+	GetWorld()->GetSubsystem<UScreenFadeSubsystem>()->FadeOut(FOnFadeFinished::CreateUObject(this, &AMazeCharacter::ToMainLevel));
+}
+
+void AMazeCharacter::CallFadeOut_Lost()
+{
+	RoundState->BeginTransition();
+
+	GetWorld()->GetSubsystem<UScreenFadeSubsystem>()->FadeOut(FOnFadeFinished::CreateUObject(this, &AMazeCharacter::RestartGame));
+}
+
+void AMazeCharacter::ToMainLevel()
+{
+	GetWorld()->GetSubsystem<ULevelTransitionSubsystem>()->ReturnToHub(true);
+}
+
+void AMazeCharacter::RestartGame()
+{
+	if (URoundResetSubsystem::IsInPlaceRestartEnabled() && RoundReset->HasSnapshot(this))
+		ResetRound();
+	else
+		GetWorld()->GetSubsystem<ULevelTransitionSubsystem>()->RestartGame();
+}
+
+void AMazeCharacter::ResetRound()
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_RoundReset);
+
+	GetWorldTimerManager().ClearAllTimersForObject(this);
+
+	// Pickups, transform and ragdoll (the maze is played alone, so its coins only belong to this player)
+	RoundReset->RestorePickups();
+	RoundReset->RestorePlayer(this);
+
+	pDead = false;
+	GetCharacterMovement()->MaxWalkSpeed = pMaxWalkSpeed;
+
+	// UI
+	if (HUDWidgets)
+	{
+		HUDWidgets->Hide(Player_Won_Widget_Class.Get());
+		HUDWidgets->Hide(Player_Lost_Widget_Class.Get());
+	}
+
+	GetWorld()->GetSubsystem<UScreenFadeSubsystem>()->FadeIn();
+
+	RoundState->ResetRound();
+	StartRound();
+}
+
+void AMazeCharacter::CallSaveGameVariables()
+{
+	UProgressSaveSubsystem* ProgressSave = UProgressSaveSubsystem::Get(this);
+
+	if (!ProgressSave)
+		return;
+
+	if (level1Won)
+		ProgressSave->MarkGameWon("Game1");
+	if (level2Won)
+		ProgressSave->MarkGameWon("Game2");
+
+	ProgressSave->SaveAsync();
+}
+
+#pragma endregion
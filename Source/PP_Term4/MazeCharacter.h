@@ -1,153 +1,233 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "GameFramework/Character.h"
-
-#include "Camera/CameraComponent.h"
-
-#include "Components/CapsuleComponent.h"
-#include "Components/StaticMeshComponent.h"
-#include "Components/InputComponent.h"
-#include "Components/SphereComponent.h"
-
-#include "Animation/SkeletalMeshActor.h"
-
-#include "Runtime/Engine/Classes/Kismet/GameplayStatics.h"
-#include "Runtime/Engine/Classes/Kismet/KismetSystemLibrary.h"
-
-#include "GameFramework/CharacterMovementComponent.h"
-#include "GameFramework/Controller.h"
-#include "GameFramework/SpringArmComponent.h"
-
-#include "Blueprint/UserWidget.h"
-
-#include "Misc/OutputDeviceNull.h"
-
-#include "MazeCharacter.generated.h"
-
-UCLASS()
-class PP_TERM4_API AMazeCharacter : public ACharacter
-{
-	GENERATED_BODY()
-
-public:
-	// Sets default values for this character's properties
-	AMazeCharacter();
-
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-
-public:
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
-	// Called to bind functionality to input
-	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
-
-public:
-	// Camera
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
-		USpringArmComponent* CameraBoom;
-
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
-		UCameraComponent* FollowCamera;
-
-
-	// Movement
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Walking")
-		float pMaxWalkSpeed;
-
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Character Movement: Walking")
-		float SprintSpeedMultiplier;
-
-
-	// Winning states
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-		bool level1Won;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-		bool level2Won;
-
-
-	// Coins variables
-	UPROPERTY(EditAnyWhere, Category = "Coins")
-		int coinsToCollect = 14;
-
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
-		float collectedCoins;
-
-
-	// Timer variables
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
-		float timer;
-
-	UPROPERTY(EditAnyWhere, Category = "Timer")
-		float startTimer = 60.0f;
-
-
-	// UI reference
-	UPROPERTY(EditAnyWhere, Category = "UI HUD")
-		TSubclassOf<UUserWidget> Player_Collect_Widget_Class;
-	UUserWidget* Player_Collect_Widget;
-
-	UPROPERTY(EditAnyWhere, Category = "UI HUD")
-		TSubclassOf<UUserWidget> Player_Won_Widget_Class;
-	UUserWidget* Player_Won_Widget;
-
-	UPROPERTY(EditAnyWhere, Category = "UI HUD")
-		TSubclassOf<UUserWidget> Player_Lost_Widget_Class;
-	UUserWidget* Player_Lost_Widget;
-
-
-	// Particle reference
-	UPROPERTY(EditAnyWhere, Category = "Particles")
-		UParticleSystem* PickingUpCoinEffect;
-
-
-	// Blueprint reference
-	UPROPERTY(EditAnywhere, Category = "BlueprintClass")
-		AActor* blueprintActor;
-
-private:
-	// Movement
-	void MoveForward(float Axis);
-	void MoveRight(float Axis);
-
-	void Sprint();
-	void StopSprinting();
-
-	void MoveCamera(float Axis);
-
-
-	// Handler
-	void HandleTimer(float pMinusAmount);
-
-
-	// Callers / Level Switchers / Data Savers
-	void CallFadeOut_Won();
-	void CallFadeOut_Lost();
-
-	void ToMainLevel();
-	void RestartGame();
-
-	void CallSaveGameVariables();
-
-
-	// Dead
-	bool pDead;
-
-
-	// Overlap
-	UFUNCTION()
-		void OnBeginOverlap(class UPrimitiveComponent* HitComponent,
-			class AActor* OtherActor, class UPrimitiveComponent* OtherComponent,
-			int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
-
-	UFUNCTION()
-		void OnEndOverlap(class UPrimitiveComponent* OverlappedComp,
-			class AActor* OtherActor, class UPrimitiveComponent* OtherComp,
-			int32 OtherBodyIndex);
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Character.h"
+
+#include "Camera/CameraComponent.h"
+
+#include "Components/CapsuleComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/InputComponent.h"
+#include "Components/SphereComponent.h"
+
+#include "Animation/SkeletalMeshActor.h"
+
+#include "Runtime/Engine/Classes/Kismet/GameplayStatics.h"
+#include "Runtime/Engine/Classes/Kismet/KismetSystemLibrary.h"
+
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/SpringArmComponent.h"
+
+#include "Blueprint/UserWidget.h"
+
+#include "AssetPreloadSubsystem.h"
+#include "GhostRacer.h"
+#include "GhostRaceSubsystem.h"
+#include "HUDDataComponent.h"
+#include "HUDWidgetSubsystem.h"
+#include "InputReplaySubsystem.h"
+#include "FeedbackEffectsSubsystem.h"
+#include "InteractionSubsystem.h"
+#include "LevelTransitionSubsystem.h"
+#include "MovementInputAccumulator.h"
+#include "ProgressSaveSubsystem.h"
+#include "PickupRegistrySubsystem.h"
+#include "PlayerHUDWidget.h"
+#include "RoundResetSubsystem.h"
+#include "RoundStateComponent.h"
+#include "ScreenFadeSubsystem.h"
+
+#include "MazeCharacter.generated.h"
+
+UCLASS()
+class PP_TERM4_API AMazeCharacter : public ACharacter
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this character's properties
+	AMazeCharacter();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Called when the character is destroyed or its level is unloaded
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	// Called to bind functionality to input
+	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
+
+public:
+	// Camera
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
+		USpringArmComponent* CameraBoom;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
+		UCameraComponent* FollowCamera;
+
+
+	// Round
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Round")
+		URoundStateComponent* RoundState;
+
+	// Values shown by the HUD
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "UI HUD")
+		UHUDDataComponent* HUDData;
+
+
+	// Movement
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Walking")
+		float pMaxWalkSpeed;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Character Movement: Walking")
+		float SprintSpeedMultiplier;
+
+
+	// Winning states
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		bool level1Won;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		bool level2Won;
+
+
+	// Coins variables (replaced by the amount of placed coins when the level has a maze generator)
+	UPROPERTY(EditAnyWhere, Category = "Coins")
+		int coinsToCollect = 14;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+		float collectedCoins;
+
+
+	// Timer variables
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+		float timer;
+
+	UPROPERTY(EditAnyWhere, Category = "Timer")
+		float startTimer = 60.0f;
+
+	// UI reference (soft, they are loaded in the background after BeginPlay)
+	UPROPERTY(EditAnyWhere, Category = "UI HUD")
+		TSoftClassPtr<UUserWidget> Player_Collect_Widget_Class;
+	UUserWidget* Player_Collect_Widget;
+
+	UPROPERTY(EditAnyWhere, Category = "UI HUD")
+		TSoftClassPtr<UUserWidget> Player_Won_Widget_Class;
+	UUserWidget* Player_Won_Widget;
+
+	UPROPERTY(EditAnyWhere, Category = "UI HUD")
+		TSoftClassPtr<UUserWidget> Player_Lost_Widget_Class;
+	UUserWidget* Player_Lost_Widget;
+
+
+	// Particle reference (soft, like the UI)
+	UPROPERTY(EditAnyWhere, Category = "Particles")
+		TSoftObjectPtr<UParticleSystem> PickingUpCoinEffect;
+
+	// Sound reference
+	UPROPERTY(EditAnyWhere, Category = "Particles")
+		USoundBase* PickingUpCoinSound;
+
+
+	// Ghost of the best run that races the player (none when not set)
+	UPROPERTY(EditAnyWhere, Category = "Ghost")
+		TSubclassOf<AGhostRacer> GhostClass;
+
+private:
+	// Movement
+	void MoveForward(float Axis);
+	void MoveRight(float Axis);
+
+	FMovementInputAccumulator MovementInput;
+
+	void Sprint();
+	void StopSprinting();
+
+	void MoveCamera(float Axis);
+
+
+	// Handlers
+	void StartRound();
+	void RefreshDisplay();
+	void OnRoundStateChanged(ERoundState OldState, ERoundState NewState);
+
+	FTimerHandle DisplayTimerHandle;
+
+	// Keeps the refresh just past the change so the rounding lands on the new value
+	static constexpr float DisplayRefreshMargin = 0.01f;
+
+
+	// Callers / Level Switchers / Data Savers
+	void CallFadeOut_Won();
+	void CallFadeOut_Lost();
+
+	void ToMainLevel();
+	void RestartGame();
+
+	// Restores the start of the round in place
+	void ResetRound();
+
+	void CallSaveGameVariables();
+
+
+	// Dead
+	bool pDead;
+
+
+	// Interactions
+	typedef void (AMazeCharacter::*FInteractionHandler)(AActor*);
+	static const FInteractionHandler InteractionHandlers[];
+
+	UInteractionSubsystem* InteractionSubsystem;
+
+
+	// UI pool of the local player
+	UHUDWidgetSubsystem* HUDWidgets;
+
+
+	// Pickup particles and sounds
+	UFeedbackEffectsSubsystem* FeedbackEffects;
+
+
+	// Soft referenced assets, kept loaded while the handles are held
+	void OnPickupAssetsLoaded();
+	void OnHUDAssetsLoaded();
+	void OnRoundEndAssetsLoaded();
+
+	TSharedPtr<FStreamableHandle> PickupAssets;
+	TSharedPtr<FStreamableHandle> HUDAssets;
+	TSharedPtr<FStreamableHandle> RoundEndAssets;
+
+
+	// Snapshot of the start of the round
+	URoundResetSubsystem* RoundReset;
+
+
+	// Records the run and races the ghost of the best one
+	UGhostRaceSubsystem* GhostRace;
+
+	// Seed and size of the generated maze (0 when the level isn't generated)
+	int32 MazeLayoutSeed;
+	FIntPoint MazeSize;
+
+	void Interact(AActor* OtherActor, EInteractionType Type);
+	void CollectCoin(AActor* Coin);
+	void AddCollectedCoin();
+
+
+	// Overlap
+	UFUNCTION()
+		void OnBeginOverlap(class UPrimitiveComponent* HitComponent,
+			class AActor* OtherActor, class UPrimitiveComponent* OtherComponent,
+			int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	UFUNCTION()
+		void OnEndOverlap(class UPrimitiveComponent* OverlappedComp,
+			class AActor* OtherActor, class UPrimitiveComponent* OtherComp,
+			int32 OtherBodyIndex);
+};
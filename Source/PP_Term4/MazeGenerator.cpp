@@ -0,0 +1,315 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MazeGenerator.h"
+#include "PP_Term4.h"
+#include "CoinFieldComponent.h"
+#include "GhostRaceSubsystem.h"
+#include "InputReplaySubsystem.h"
+#include "PickupRegistrySubsystem.h"
+#include "TheLabStats.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+
+static TAutoConsoleVariable<int32> CVarMazeSize(
+	TEXT("thelab.Maze.Size"),
+	0,
+	TEXT("Overrides the width and height of generated mazes, e.g. 100 to stress test a 100x100 maze (0 = use the size of the actor)."),
+	ECVF_Default);
+
+// Sets default values
+AMazeGenerator::AMazeGenerator()
+{
+	// Only builds the maze once, so it never has to tick
+	PrimaryActorTick.bCanEverTick = false;
+
+	Root = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+	Root->SetMobility(EComponentMobility::Static);
+	RootComponent = Root;
+
+	WallInstances = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("WallInstances"));
+	WallInstances->SetupAttachment(RootComponent);
+	WallInstances->SetMobility(EComponentMobility::Static);
+	WallInstances->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+
+	FloorInstances = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("FloorInstances"));
+	FloorInstances->SetupAttachment(RootComponent);
+	FloorInstances->SetMobility(EComponentMobility::Static);
+	FloorInstances->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+
+	CoinField = CreateDefaultSubobject<UCoinFieldComponent>(TEXT("CoinField"));
+	CoinField->SetupAttachment(RootComponent);
+
+	WallMesh = nullptr;
+	FloorMesh = nullptr;
+
+	LayoutSeed = 0;
+	bGenerated = false;
+}
+
+// Called when the game starts or when spawned
+void AMazeGenerator::BeginPlay()
+{
+	Super::BeginPlay();
+
+	EnsureGenerated();
+}
+
+void AMazeGenerator::EnsureGenerated()
+{
+	if (bGenerated)
+		return;
+
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_MazeGenerate);
+
+	bGenerated = true;
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	if (CVarMazeSize.GetValueOnGameThread() > 0)
+	{
+		Width = CVarMazeSize.GetValueOnGameThread();
+		Height = Width;
+	}
+
+	Width = FMath::Max(Width, 2);
+	Height = FMath::Max(Height, 2);
+	StartCell.X = FMath::Clamp(StartCell.X, 0, Width - 1);
+	StartCell.Y = FMath::Clamp(StartCell.Y, 0, Height - 1);
+
+	// The maze of the best run when it is raced, otherwise seeded per world so a replayed session gets the same maze
+	UGhostRaceSubsystem* GhostRace = UGhostRaceSubsystem::Get(this);
+
+	LayoutSeed = Seed;
+
+	if (LayoutSeed == 0 && GhostRace)
+		LayoutSeed = GhostRace->GetLayoutSeed(GetWorld(), GetSize());
+	if (LayoutSeed == 0)
+		LayoutSeed = UInputReplaySubsystem::GetRandomSeed(this);
+
+	FRandomStream Random(LayoutSeed);
+
+	CarveMaze(Random);
+	BuildInstances();
+	PlaceCoins(Random);
+
+	UE_LOG(LogTheLab, Log, TEXT("Maze %dx%d generated in %.2f ms: %d walls, %d floor tiles, %d coins"),
+		Width, Height, (FPlatformTime::Seconds() - StartTime) * 1000.0,
+		WallInstances->GetInstanceCount(), FloorInstances->GetInstanceCount(), GetNumPlacedCoins());
+}
+
+int32 AMazeGenerator::GetNumPlacedCoins() const
+{
+	return PlacedCoins.Num() + CoinField->GetNumCoins();
+}
+
+void AMazeGenerator::CarveMaze(FRandomStream& Random)
+{
+	const int32 NumCells = Width * Height;
+
+	EastWalls.Init(true, NumCells);
+	SouthWalls.Init(true, NumCells);
+
+	TBitArray<> Visited(false, NumCells);
+
+	// Depth-first search with an explicit stack, which stays cheap for very large mazes
+	TArray<int32> Stack;
+	Stack.Reserve(NumCells);
+
+	const int32 Start = GetCellIndex(StartCell.X, StartCell.Y);
+	Visited[Start] = true;
+	Stack.Add(Start);
+
+	while (Stack.Num() > 0)
+	{
+		const int32 Cell = Stack.Last();
+		const int32 X = Cell % Width;
+		const int32 Y = Cell / Width;
+
+		// Unvisited neighbours
+		int32 Neighbours[4];
+		int32 NumNeighbours = 0;
+
+		if (X > 0 && !Visited[Cell - 1])
+			Neighbours[NumNeighbours++] = Cell - 1;
+		if (X < Width - 1 && !Visited[Cell + 1])
+			Neighbours[NumNeighbours++] = Cell + 1;
+		if (Y > 0 && !Visited[Cell - Width])
+			Neighbours[NumNeighbours++] = Cell - Width;
+		if (Y < Height - 1 && !Visited[Cell + Width])
+			Neighbours[NumNeighbours++] = Cell + Width;
+
+		if (NumNeighbours == 0)
+		{
+			Stack.Pop(false);
+			continue;
+		}
+
+		const int32 Next = Neighbours[Random.RandRange(0, NumNeighbours - 1)];
+
+		// Remove the wall between the cells (every cell owns its east and south wall)
+		if (Next == Cell + 1)
+			EastWalls[Cell] = false;
+		else if (Next == Cell - 1)
+			EastWalls[Next] = false;
+		else if (Next == Cell + Width)
+			SouthWalls[Cell] = false;
+		else
+			SouthWalls[Next] = false;
+
+		Visited[Next] = true;
+		Stack.Add(Next);
+	}
+}
+
+void AMazeGenerator::BuildInstances()
+{
+	WallInstances->ClearInstances();
+	FloorInstances->ClearInstances();
+
+	WallInstances->SetStaticMesh(WallMesh);
+	FloorInstances->SetStaticMesh(FloorMesh);
+
+	const float Scale = 1.0f / MeshSize;
+	const float WallZ = WallHeight * 0.5f;
+
+	const FVector EastWallScale = FVector(WallThickness, CellSize + WallThickness, WallHeight) * Scale;
+	const FVector SouthWallScale = FVector(CellSize + WallThickness, WallThickness, WallHeight) * Scale;
+	const FVector FloorScale = FVector(CellSize, CellSize, FloorThickness) * Scale;
+
+	TArray<FTransform> Walls;
+	TArray<FTransform> Floors;
+	Walls.Reserve(Width * Height * 2 + Width + Height);
+	Floors.Reserve(Width * Height);
+
+	// Outer walls on the north and west side (the east and south side are the walls of the last cells)
+	for (int32 X = 0; X < Width; X++)
+		Walls.Add(FTransform(FRotator::ZeroRotator, FVector((X + 0.5f) * CellSize, 0.0f, WallZ), SouthWallScale));
+
+	for (int32 Y = 0; Y < Height; Y++)
+		Walls.Add(FTransform(FRotator::ZeroRotator, FVector(0.0f, (Y + 0.5f) * CellSize, WallZ), EastWallScale));
+
+	for (int32 Y = 0; Y < Height; Y++)
+	{
+		for (int32 X = 0; X < Width; X++)
+		{
+			const int32 Cell = GetCellIndex(X, Y);
+
+			if (EastWalls[Cell])
+				Walls.Add(FTransform(FRotator::ZeroRotator, FVector((X + 1) * CellSize, (Y + 0.5f) * CellSize, WallZ), EastWallScale));
+
+			if (SouthWalls[Cell])
+				Walls.Add(FTransform(FRotator::ZeroRotator, FVector((X + 0.5f) * CellSize, (Y + 1) * CellSize, WallZ), SouthWallScale));
+
+			Floors.Add(FTransform(FRotator::ZeroRotator, FVector((X + 0.5f) * CellSize, (Y + 0.5f) * CellSize, -FloorThickness * 0.5f), FloorScale));
+		}
+	}
+
+	// One batch per component, so the cluster tree is only built once
+	if (WallMesh)
+		WallInstances->AddInstances(Walls, false);
+
+	if (FloorMesh)
+		FloorInstances->AddInstances(Floors, false);
+}
+
+void AMazeGenerator::PlaceCoins(FRandomStream& Random)
+{
+	PlacedCoins.Reset();
+
+	const bool bInstancedCoins = CoinField->GetStaticMesh() != nullptr;
+
+	if ((!bInstancedCoins && !CoinClass) || NumCoins <= 0)
+		return;
+
+	// Cells that can be reached from the start cell through the open walls
+	const int32 NumCells = Width * Height;
+	const int32 Start = GetCellIndex(StartCell.X, StartCell.Y);
+
+	TBitArray<> Reached(false, NumCells);
+	TArray<int32> Reachable;
+	Reachable.Reserve(NumCells);
+
+	Reached[Start] = true;
+	Reachable.Add(Start);
+
+	for (int32 Index = 0; Index < Reachable.Num(); Index++)
+	{
+		const int32 Cell = Reachable[Index];
+		const int32 X = Cell % Width;
+		const int32 Y = Cell / Width;
+
+		int32 Neighbours[4];
+		int32 NumNeighbours = 0;
+
+		if (X > 0 && !EastWalls[Cell - 1])
+			Neighbours[NumNeighbours++] = Cell - 1;
+		if (X < Width - 1 && !EastWalls[Cell])
+			Neighbours[NumNeighbours++] = Cell + 1;
+		if (Y > 0 && !SouthWalls[Cell - Width])
+			Neighbours[NumNeighbours++] = Cell - Width;
+		if (Y < Height - 1 && !SouthWalls[Cell])
+			Neighbours[NumNeighbours++] = Cell + Width;
+
+		for (int32 Neighbour = 0; Neighbour < NumNeighbours; Neighbour++)
+		{
+			if (Reached[Neighbours[Neighbour]])
+				continue;
+
+			Reached[Neighbours[Neighbour]] = true;
+			Reachable.Add(Neighbours[Neighbour]);
+		}
+	}
+
+	// Never put a coin under the player
+	Reachable.RemoveAtSwap(0, 1, false);
+
+	// Pick distinct cells with a partial shuffle
+	const int32 NumToPlace = FMath::Min(NumCoins, Reachable.Num());
+
+	for (int32 Index = 0; Index < NumToPlace; Index++)
+		Reachable.Swap(Index, Random.RandRange(Index, Reachable.Num() - 1));
+
+	TArray<FVector> Locations;
+	Locations.Reserve(NumToPlace);
+
+	for (int32 Index = 0; Index < NumToPlace; Index++)
+		Locations.Add(GetCellCenter(Reachable[Index] % Width, Reachable[Index] / Width) + FVector(0.0f, 0.0f, CoinHeight));
+
+	// All coins in one instanced mesh, collected by instance index
+	if (bInstancedCoins)
+	{
+		CoinField->AddCoins(Locations, Random);
+		return;
+	}
+
+	UPickupRegistrySubsystem* PickupRegistry = GetWorld()->GetSubsystem<UPickupRegistrySubsystem>();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = this;
+	SpawnParams.OverrideLevel = GetLevel();
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	for (const FVector& Location : Locations)
+	{
+		AActor* Coin = GetWorld()->SpawnActor<AActor>(CoinClass, Location, FRotator::ZeroRotator, SpawnParams);
+
+		if (!Coin)
+			continue;
+
+		PlacedCoins.Add(Coin);
+
+		// The registry only finds the pickups placed in the level by itself
+		if (PickupRegistry && PickupRegistry->IsActive())
+			PickupRegistry->Register(Coin, EInteractionType::Coin);
+	}
+}
+
+FVector AMazeGenerator::GetCellCenter(int32 X, int32 Y) const
+{
+	return GetActorTransform().TransformPosition(FVector((X + 0.5f) * CellSize, (Y + 0.5f) * CellSize, 0.0f));
+}
@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+
+#include "MazeGenerator.generated.h"
+
+class UCoinFieldComponent;
+class UHierarchicalInstancedStaticMeshComponent;
+class UStaticMesh;
+
+/**
+ * Generates a grid maze from a seed when the game starts.
+ * All walls and floor tiles are instances of two hierarchical instanced meshes, so the draw calls and the actor count
+ * don't grow with the size of the maze. Coins are spawned on cells that can be reached from the start cell.
+ */
+UCLASS()
+class PP_TERM4_API AMazeGenerator : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AMazeGenerator();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+public:
+	// Builds the maze and spawns the coins the first time it is called
+	void EnsureGenerated();
+
+	bool IsGenerated() const { return bGenerated; }
+
+	// Coins that were actually placed
+	int32 GetNumPlacedCoins() const;
+
+	// Seed the maze was generated with
+	int32 GetLayoutSeed() const { return LayoutSeed; }
+
+	// Cells of the maze (after thelab.Maze.Size)
+	FIntPoint GetSize() const { return FIntPoint(Width, Height); }
+
+	// Size of the maze in cells
+	UPROPERTY(EditAnywhere, Category = "Maze", meta = (ClampMin = "2"))
+		int32 Width = 12;
+
+	UPROPERTY(EditAnywhere, Category = "Maze", meta = (ClampMin = "2"))
+		int32 Height = 12;
+
+	// Seed of the layout and the coins (0 uses the seed of the best run's ghost, or else the seed of the world, which the input replay records)
+	UPROPERTY(EditAnywhere, Category = "Maze")
+		int32 Seed = 0;
+
+	// Cell the player starts in (coins are never placed there), cell 0,0 is at the location of the actor
+	UPROPERTY(EditAnywhere, Category = "Maze")
+		FIntPoint StartCell = FIntPoint(0, 0);
+
+	// Dimensions
+	UPROPERTY(EditAnywhere, Category = "Maze Dimensions")
+		float CellSize = 400.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Maze Dimensions")
+		float WallHeight = 300.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Maze Dimensions")
+		float WallThickness = 40.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Maze Dimensions")
+		float FloorThickness = 20.0f;
+
+	// Size of the meshes (a centred cube of this size, like the engine cube)
+	UPROPERTY(EditAnywhere, Category = "Maze Dimensions")
+		float MeshSize = 100.0f;
+
+	// Meshes
+	UPROPERTY(EditAnywhere, Category = "Maze Meshes")
+		UStaticMesh* WallMesh;
+
+	UPROPERTY(EditAnywhere, Category = "Maze Meshes")
+		UStaticMesh* FloorMesh;
+
+	// Coins (instances of the coin field when it has a mesh, otherwise actors of the class)
+	UPROPERTY(EditAnywhere, Category = "Coins")
+		TSubclassOf<AActor> CoinClass;
+
+	UPROPERTY(EditAnywhere, Category = "Coins")
+		int32 NumCoins = 14;
+
+	UPROPERTY(EditAnywhere, Category = "Coins")
+		float CoinHeight = 100.0f;
+
+private:
+	// Walls between the cells, carved with a depth-first search
+	void CarveMaze(FRandomStream& Random);
+
+	void BuildInstances();
+	void PlaceCoins(FRandomStream& Random);
+
+	int32 GetCellIndex(int32 X, int32 Y) const { return Y * Width + X; }
+	FVector GetCellCenter(int32 X, int32 Y) const;
+
+	UPROPERTY(VisibleAnywhere, Category = "Maze")
+		USceneComponent* Root;
+
+	UPROPERTY(VisibleAnywhere, Category = "Maze")
+		UHierarchicalInstancedStaticMeshComponent* WallInstances;
+
+	UPROPERTY(VisibleAnywhere, Category = "Maze")
+		UHierarchicalInstancedStaticMeshComponent* FloorInstances;
+
+	UPROPERTY(VisibleAnywhere, Category = "Coins")
+		UCoinFieldComponent* CoinField;
+
+	UPROPERTY()
+		TArray<AActor*> PlacedCoins;
+
+	// Whether the east and south wall of every cell is still standing
+	TBitArray<> EastWalls;
+	TBitArray<> SouthWalls;
+
+	int32 LayoutSeed;
+
+	bool bGenerated;
+};
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementInputAccumulator.h"
+#include "PP_Term4.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+FMovementInputAccumulator::FMovementInputAccumulator()
+{
+	ForwardAxis = 0.0f;
+	RightAxis = 0.0f;
+
+	bHasBasis = false;
+	BasisYaw = 0.0f;
+	BasisForward = FVector::ForwardVector;
+	BasisRight = FVector::RightVector;
+}
+
+void FMovementInputAccumulator::Flush(APawn* Pawn)
+{
+	if (ForwardAxis == 0.0f && RightAxis == 0.0f)
+		return;
+
+	// The controller is gone for a moment while possession changes
+	const AController* Controller = Pawn ? Pawn->GetController() : nullptr;
+
+	if (!Controller)
+	{
+		Reset();
+		return;
+	}
+
+	// Rebuild the basis only when the yaw changed
+	const float Yaw = Controller->GetControlRotation().Yaw;
+
+	if (!bHasBasis || Yaw != BasisYaw)
+	{
+		float Sin, Cos;
+		FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(Yaw));
+
+		BasisForward = FVector(Cos, Sin, 0.0f);
+		BasisRight = FVector(-Sin, Cos, 0.0f);
+
+		BasisYaw = Yaw;
+		bHasBasis = true;
+	}
+
+	Pawn->AddMovementInput(BasisForward * ForwardAxis + BasisRight * RightAxis);
+
+	Reset();
+}
+
+void FMovementInputAccumulator::Reset()
+{
+	ForwardAxis = 0.0f;
+	RightAxis = 0.0f;
+}
+
+// Microbenchmark of the movement input of one frame, the per-axis rotation matrices against the accumulator
+static FAutoConsoleCommandWithWorldAndArgs GMovementInputBenchmarkCommand(
+	TEXT("thelab.Bench.MovementInput"),
+	TEXT("Times the movement input of a frame with and without the accumulator. Usage: thelab.Bench.MovementInput [Frames]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+		APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+
+		if (!Pawn)
+		{
+			UE_LOG(LogTheLab, Warning, TEXT("thelab.Bench.MovementInput needs a possessed pawn"));
+			return;
+		}
+
+		const int32 Frames = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100000;
+
+		// Old path, one rotation matrix and movement input per axis
+		auto LegacyFrame = [Pawn](float Forward, float Right)
+		{
+			const FRotator ForwardYaw(0, Pawn->Controller->GetControlRotation().Yaw, 0);
+			Pawn->AddMovementInput(FRotationMatrix(ForwardYaw).GetUnitAxis(EAxis::X), Forward);
+
+			const FRotator RightYaw(0, Pawn->Controller->GetControlRotation().Yaw, 0);
+			Pawn->AddMovementInput(FRotationMatrix(RightYaw).GetUnitAxis(EAxis::Y), Right);
+		};
+
+		FMovementInputAccumulator Accumulator;
+
+		auto AccumulatorFrame = [Pawn, &Accumulator](float Forward, float Right)
+		{
+			Accumulator.AddForward(Forward);
+			Accumulator.AddRight(Right);
+			Accumulator.Flush(Pawn);
+		};
+
+		auto TimeFrames = [Pawn, Frames](const TFunctionRef<void(float, float)>& Frame, float Forward, float Right)
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+
+			for (int32 Index = 0; Index < Frames; Index++)
+				Frame(Forward, Right);
+
+			const double Nanoseconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) * 1e9 / Frames;
+
+			// Throw away the input the benchmark added
+			Pawn->ConsumeMovementInputVector();
+
+			return Nanoseconds;
+		};
+
+		UE_LOG(LogTheLab, Log, TEXT("Movement input per frame over %d frames:"), Frames);
+		UE_LOG(LogTheLab, Log, TEXT("  moving: %.1f ns before, %.1f ns after"), TimeFrames(LegacyFrame, 1.0f, 1.0f), TimeFrames(AccumulatorFrame, 1.0f, 1.0f));
+		UE_LOG(LogTheLab, Log, TEXT("  idle:   %.1f ns before, %.1f ns after"), TimeFrames(LegacyFrame, 0.0f, 0.0f), TimeFrames(AccumulatorFrame, 0.0f, 0.0f));
+	}));
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Pawn.h"
+
+/**
+ * Sums the movement axes of a frame and hands them to the pawn as one movement input.
+ * The yaw basis is only rebuilt when the control yaw changes, and idle frames cost nothing.
+ */
+struct PP_TERM4_API FMovementInputAccumulator
+{
+public:
+	FMovementInputAccumulator();
+
+	void AddForward(float Axis) { ForwardAxis += Axis; }
+	void AddRight(float Axis) { RightAxis += Axis; }
+
+	// Sends the summed input to the pawn and resets it (skipped when there's no input or no controller)
+	void Flush(APawn* Pawn);
+
+	void Reset();
+
+private:
+	// Summed axes of this frame
+	float ForwardAxis;
+	float RightAxis;
+
+	// Yaw basis of the last flush
+	bool bHasBasis;
+	float BasisYaw;
+	FVector BasisForward;
+	FVector BasisRight;
+};
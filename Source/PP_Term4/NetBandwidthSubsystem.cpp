@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetBandwidthSubsystem.h"
+#include "PP_Term4.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+#include "TimerManager.h"
+
+static TAutoConsoleVariable<float> CVarBandwidthReportInterval(
+	TEXT("thelab.Net.BandwidthReportInterval"),
+	0.0f,
+	TEXT("Seconds between two bandwidth samples of every client connection on a server (0 = off).\n")
+	TEXT("Read when a level starts."));
+
+// Console command to print the averages of the current world
+static FAutoConsoleCommandWithWorld GNetBandwidthStatsCommand(
+	TEXT("thelab.Net.Stats"),
+	TEXT("Logs the average bandwidth per player in the current world."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UNetBandwidthSubsystem* NetBandwidth = World ? World->GetSubsystem<UNetBandwidthSubsystem>() : nullptr)
+			NetBandwidth->LogStats();
+	}));
+
+void UNetBandwidthSubsystem::Deinitialize()
+{
+	if (Connections.Num() > 0)
+		LogStats();
+
+	Connections.Empty();
+
+	Super::Deinitialize();
+}
+
+void UNetBandwidthSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	const float Interval = CVarBandwidthReportInterval.GetValueOnGameThread();
+
+	// Only a server has client connections
+	if (Interval <= 0.0f || (InWorld.GetNetMode() != NM_ListenServer && InWorld.GetNetMode() != NM_DedicatedServer))
+		return;
+
+	InWorld.GetTimerManager().SetTimer(SampleTimerHandle, FTimerDelegate::CreateUObject(this, &UNetBandwidthSubsystem::Sample), Interval, true);
+}
+
+void UNetBandwidthSubsystem::Sample()
+{
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+
+	if (!NetDriver)
+		return;
+
+	for (UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		if (!Connection)
+			continue;
+
+		FConnectionBandwidth& Bandwidth = Connections.FindOrAdd(Connection);
+
+		// Rates of the last second, kept up to date by the connection
+		Bandwidth.OutBytesSum += Connection->OutBytesPerSecond;
+		Bandwidth.InBytesSum += Connection->InBytesPerSecond;
+		Bandwidth.PeakOutBytes = FMath::Max(Bandwidth.PeakOutBytes, Connection->OutBytesPerSecond);
+		Bandwidth.NumSamples++;
+
+		const APlayerState* PlayerState = Connection->PlayerController ? Connection->PlayerController->PlayerState : nullptr;
+
+		if (PlayerState)
+			Bandwidth.PlayerName = PlayerState->GetPlayerName();
+
+		UE_LOG(LogTheLab, Log, TEXT("Bandwidth %s: %d B/s out, %d B/s in"),
+			*Bandwidth.PlayerName, Connection->OutBytesPerSecond, Connection->InBytesPerSecond);
+	}
+}
+
+void UNetBandwidthSubsystem::LogStats() const
+{
+	int64 TotalOut = 0;
+	int32 NumPlayers = 0;
+
+	for (const TPair<TObjectKey<UNetConnection>, FConnectionBandwidth>& Pair : Connections)
+	{
+		const FConnectionBandwidth& Bandwidth = Pair.Value;
+
+		if (Bandwidth.NumSamples == 0)
+			continue;
+
+		const int64 AverageOut = Bandwidth.OutBytesSum / Bandwidth.NumSamples;
+
+		UE_LOG(LogTheLab, Log, TEXT("Bandwidth of %s: %lld B/s out (peak %d), %lld B/s in, over %d samples"),
+			*Bandwidth.PlayerName, AverageOut, Bandwidth.PeakOutBytes, Bandwidth.InBytesSum / Bandwidth.NumSamples, Bandwidth.NumSamples);
+
+		TotalOut += AverageOut;
+		NumPlayers++;
+	}
+
+	UE_LOG(LogTheLab, Log, TEXT("Bandwidth: %d players, %lld B/s out per player on average"),
+		NumPlayers, NumPlayers > 0 ? TotalOut / NumPlayers : 0);
+}
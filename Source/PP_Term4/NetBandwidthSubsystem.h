@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "NetBandwidthSubsystem.generated.h"
+
+class UNetConnection;
+
+// Bandwidth samples of one client connection
+struct FConnectionBandwidth
+{
+	FString PlayerName;
+
+	int64 OutBytesSum = 0;
+	int64 InBytesSum = 0;
+	int32 PeakOutBytes = 0;
+	int32 NumSamples = 0;
+};
+
+/**
+ * Measures the bandwidth per player on a listen or dedicated server.
+ * Every thelab.Net.BandwidthReportInterval seconds the bytes per second sent to and received from every client
+ * connection are sampled and logged, and the averages of the whole session are logged when the world ends.
+ */
+UCLASS()
+class PP_TERM4_API UNetBandwidthSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	// Samples every client connection once
+	void Sample();
+
+	void LogStats() const;
+
+private:
+	TMap<TObjectKey<UNetConnection>, FConnectionBandwidth> Connections;
+
+	FTimerHandle SampleTimerHandle;
+};
@@ -1,7 +1,9 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
-
-#include "PP_Term4.h"
-#include "Modules/ModuleManager.h"
-
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, PP_Term4, "PP_Term4" );
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PP_Term4.h"
+#include "Modules/ModuleManager.h"
+
+DEFINE_LOG_CATEGORY(LogTheLab);
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, PP_Term4, "PP_Term4" );
  
\ No newline at end of file
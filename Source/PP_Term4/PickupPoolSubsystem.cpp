@@ -0,0 +1,258 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PickupPoolSubsystem.h"
+#include "PP_Term4.h"
+#include "TheLabStats.h"
+#include "Components/ActorComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+// Console command to print the counters of the pools in the current world
+static FAutoConsoleCommandWithWorld GPickupPoolStatsCommand(
+	TEXT("thelab.Pool.Stats"),
+	TEXT("Logs the hit/miss counters of the pickup pools in the current world."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UPickupPoolSubsystem* PickupPool = World ? World->GetSubsystem<UPickupPoolSubsystem>() : nullptr)
+			PickupPool->LogStats();
+	}));
+
+void UPickupPoolSubsystem::Deinitialize()
+{
+	LogStats();
+
+	Pools.Empty();
+	ActiveActors.Empty();
+
+	Super::Deinitialize();
+}
+
+void UPickupPoolSubsystem::Prewarm(TSubclassOf<AActor> ActorClass, int32 Count, int32 MaxSize)
+{
+	if (!ActorClass)
+		return;
+
+	FPickupPool& Pool = Pools.FindOrAdd(ActorClass);
+	Pool.MaxSize = FMath::Max(MaxSize, 1);
+
+	// Fill the pool with inactive actors
+	const int32 TargetCount = FMath::Min(Count, Pool.MaxSize);
+
+	while (Pool.NumSpawned < TargetCount)
+	{
+		AActor* Actor = SpawnPooledActor(ActorClass);
+
+		if (!Actor)
+			break;
+
+		DeactivateActor(Actor);
+		Pool.FreeActors.Add(Actor);
+		Pool.NumSpawned++;
+	}
+}
+
+AActor* UPickupPoolSubsystem::Acquire(TSubclassOf<AActor> ActorClass, const FVector& Location, const FRotator& Rotation)
+{
+	if (!ActorClass)
+		return nullptr;
+
+	FPickupPool* Pool = Pools.Find(ActorClass);
+
+	// Classes that weren't prewarmed get a pool without a cap
+	if (!Pool)
+	{
+		Pool = &Pools.Add(ActorClass);
+		Pool->MaxSize = MAX_int32;
+	}
+
+	AActor* Actor = nullptr;
+
+	// Take an inactive actor (destroyed actors already left the free list, see OnPooledActorDestroyed)
+	while (!Actor && Pool->FreeActors.Num() > 0)
+	{
+		Actor = Pool->FreeActors.Pop(false);
+
+		if (!IsValid(Actor))
+			Actor = nullptr;
+	}
+
+	if (Actor)
+		Pool->Hits++;
+	else if (Pool->NumSpawned < Pool->MaxSize)
+	{
+		// Grow the pool
+		Actor = SpawnPooledActor(ActorClass);
+
+		if (!Actor)
+			return nullptr;
+
+		Pool->NumSpawned++;
+		Pool->Misses++;
+	}
+	else
+	{
+		Pool->Rejected++;
+		return nullptr;
+	}
+
+	ActivateActor(Actor, Location, Rotation);
+	ActiveActors.Add(Actor, ActorClass);
+
+	SET_DWORD_STAT(STAT_TheLab_ActivePooledPickups, ActiveActors.Num());
+
+	return Actor;
+}
+
+bool UPickupPoolSubsystem::Release(AActor* Actor)
+{
+	UClass* ActorClass = nullptr;
+
+	if (!Actor || !ActiveActors.RemoveAndCopyValue(Actor, ActorClass))
+		return false;
+
+	DeactivateActor(Actor);
+
+	if (FPickupPool* Pool = Pools.Find(ActorClass))
+		Pool->FreeActors.Add(Actor);
+
+	SET_DWORD_STAT(STAT_TheLab_ActivePooledPickups, ActiveActors.Num());
+
+	return true;
+}
+
+void UPickupPoolSubsystem::ReleaseAll(TArray<AActor*>& OutReleased)
+{
+	for (const TPair<TObjectKey<AActor>, UClass*>& Pair : ActiveActors)
+	{
+		AActor* Actor = Pair.Key.ResolveObjectPtr();
+		FPickupPool* Pool = Pools.Find(Pair.Value);
+
+		if (!IsValid(Actor))
+			continue;
+
+		DeactivateActor(Actor);
+		OutReleased.Add(Actor);
+
+		if (Pool)
+			Pool->FreeActors.Add(Actor);
+	}
+
+	ActiveActors.Reset();
+
+	SET_DWORD_STAT(STAT_TheLab_ActivePooledPickups, 0);
+}
+
+bool UPickupPoolSubsystem::IsPooled(const AActor* Actor) const
+{
+	if (!Actor)
+		return false;
+
+	if (ActiveActors.Contains(Actor))
+		return true;
+
+	const FPickupPool* Pool = Pools.Find(Actor->GetClass());
+	return Pool && Pool->FreeActors.Contains(Actor);
+}
+
+bool UPickupPoolSubsystem::IsActive(const AActor* Actor) const
+{
+	return Actor && ActiveActors.Contains(Actor);
+}
+
+int32 UPickupPoolSubsystem::GetHits() const
+{
+	int32 Hits = 0;
+
+	for (const TPair<UClass*, FPickupPool>& Pair : Pools)
+		Hits += Pair.Value.Hits;
+
+	return Hits;
+}
+
+int32 UPickupPoolSubsystem::GetMisses() const
+{
+	int32 Misses = 0;
+
+	for (const TPair<UClass*, FPickupPool>& Pair : Pools)
+		Misses += Pair.Value.Misses;
+
+	return Misses;
+}
+
+int32 UPickupPoolSubsystem::GetNumActive() const
+{
+	return ActiveActors.Num();
+}
+
+void UPickupPoolSubsystem::LogStats() const
+{
+	for (const TPair<UClass*, FPickupPool>& Pair : Pools)
+	{
+		const FPickupPool& Pool = Pair.Value;
+
+		UE_LOG(LogTheLab, Log, TEXT("Pickup pool %s: %d spawned (cap %d), %d free, %d hits, %d misses, %d rejected"),
+			*GetNameSafe(Pair.Key), Pool.NumSpawned, Pool.MaxSize, Pool.FreeActors.Num(), Pool.Hits, Pool.Misses, Pool.Rejected);
+	}
+}
+
+AActor* UPickupPoolSubsystem::SpawnPooledActor(UClass* ActorClass)
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AActor* Actor = GetWorld()->SpawnActor<AActor>(ActorClass, FVector::ZeroVector, FRotator::ZeroRotator, SpawnParameters);
+
+	if (Actor)
+		Actor->OnDestroyed.AddDynamic(this, &UPickupPoolSubsystem::OnPooledActorDestroyed);
+
+	return Actor;
+}
+
+void UPickupPoolSubsystem::OnPooledActorDestroyed(AActor* Actor)
+{
+	UClass* ActorClass = Actor->GetClass();
+	const bool bWasActive = ActiveActors.RemoveAndCopyValue(Actor, ActorClass);
+
+	if (FPickupPool* Pool = Pools.Find(ActorClass))
+	{
+		// Frees its slot, the pool may spawn a replacement
+		Pool->NumSpawned--;
+
+		if (!bWasActive)
+			Pool->FreeActors.RemoveSingleSwap(Actor, false);
+	}
+
+	if (bWasActive)
+		SET_DWORD_STAT(STAT_TheLab_ActivePooledPickups, ActiveActors.Num());
+}
+
+void UPickupPoolSubsystem::ActivateActor(AActor* Actor, const FVector& Location, const FRotator& Rotation)
+{
+	Actor->SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::ResetPhysics);
+
+	Actor->SetActorHiddenInGame(false);
+	Actor->SetActorEnableCollision(true);
+
+	// Only restore ticking for the actor and components that tick by default
+	Actor->SetActorTickEnabled(Actor->PrimaryActorTick.bStartWithTickEnabled);
+
+	for (UActorComponent* Component : Actor->GetComponents())
+	{
+		if (Component)
+			Component->SetComponentTickEnabled(Component->PrimaryComponentTick.bStartWithTickEnabled);
+	}
+}
+
+void UPickupPoolSubsystem::DeactivateActor(AActor* Actor)
+{
+	Actor->SetActorHiddenInGame(true);
+	Actor->SetActorEnableCollision(false);
+	Actor->SetActorTickEnabled(false);
+
+	for (UActorComponent* Component : Actor->GetComponents())
+	{
+		if (Component)
+			Component->SetComponentTickEnabled(false);
+	}
+}
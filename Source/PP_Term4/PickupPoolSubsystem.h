@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameFramework/Actor.h"
+
+#include "PickupPoolSubsystem.generated.h"
+
+// Pool of actors of a single class
+USTRUCT()
+struct FPickupPool
+{
+	GENERATED_BODY()
+
+	// Inactive actors that are ready to be handed out
+	UPROPERTY()
+		TArray<AActor*> FreeActors;
+
+	// Maximum amount of actors (active + inactive) this pool may own
+	int32 MaxSize = 0;
+
+	// Amount of actors this pool has spawned
+	int32 NumSpawned = 0;
+
+	// Counters
+	int32 Hits = 0;			// Acquire served from the free list
+	int32 Misses = 0;		// Acquire had to spawn a new actor
+	int32 Rejected = 0;		// Acquire failed because the pool was at its cap
+};
+
+/**
+ * Keeps pickup actors alive for the lifetime of the world and recycles them,
+ * instead of spawning and destroying an actor for every pickup.
+ * Inactive actors are hidden, have no collision and don't tick.
+ */
+UCLASS()
+class PP_TERM4_API UPickupPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Spawns inactive actors of the class until the pool holds Count actors (never more than MaxSize)
+	void Prewarm(TSubclassOf<AActor> ActorClass, int32 Count, int32 MaxSize);
+
+	// Activates an actor of the class at the given location, grows the pool when it is empty (returns nullptr at the cap)
+	AActor* Acquire(TSubclassOf<AActor> ActorClass, const FVector& Location, const FRotator& Rotation);
+
+	// Deactivates the actor and returns it to its pool (returns false when the actor isn't owned by a pool)
+	bool Release(AActor* Actor);
+
+	// Returns every active actor to its pool
+	void ReleaseAll(TArray<AActor*>& OutReleased);
+
+	bool IsPooled(const AActor* Actor) const;
+
+	// Whether the actor is handed out by a pool
+	bool IsActive(const AActor* Actor) const;
+
+	// Counters
+	int32 GetHits() const;
+	int32 GetMisses() const;
+	int32 GetNumActive() const;
+
+	void LogStats() const;
+
+private:
+	AActor* SpawnPooledActor(UClass* ActorClass);
+
+	// Forgets an actor of a pool that got destroyed from outside the pool
+	UFUNCTION()
+		void OnPooledActorDestroyed(AActor* Actor);
+
+	void ActivateActor(AActor* Actor, const FVector& Location, const FRotator& Rotation);
+	void DeactivateActor(AActor* Actor);
+
+	// Pools per actor class
+	UPROPERTY()
+		TMap<UClass*, FPickupPool> Pools;
+
+	// Actors that are currently handed out, and the class of the pool they belong to
+	TMap<TObjectKey<AActor>, UClass*> ActiveActors;
+};
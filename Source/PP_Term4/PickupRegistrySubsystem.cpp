@@ -0,0 +1,225 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PickupRegistrySubsystem.h"
+#include "PP_Term4.h"
+#include "TheLabStats.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<bool> CVarUsePickupRegistry(
+	TEXT("thelab.Pickups.UseRegistry"),
+	false,
+	TEXT("Collect coins and recharges with one batched proximity query per frame instead of overlap events.\n")
+	TEXT("Read when a level starts."));
+
+static TAutoConsoleVariable<float> CVarPickupRegistryCellSize(
+	TEXT("thelab.Pickups.CellSize"),
+	500.0f,
+	TEXT("Size of a cell of the pickup spatial hash (in cm). Read when a level starts."));
+
+void UPickupRegistrySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	bActive = GetWorld()->IsGameWorld() && CVarUsePickupRegistry.GetValueOnGameThread();
+	CellSize = FMath::Max(CVarPickupRegistryCellSize.GetValueOnGameThread(), 1.0f);
+	MaxRadius = 0.0f;
+}
+
+void UPickupRegistrySubsystem::Deinitialize()
+{
+	Positions.Empty();
+	Radii.Empty();
+	Types.Empty();
+	Actors.Empty();
+	FreeSlots.Empty();
+	ActorToSlot.Empty();
+	Cells.Empty();
+
+	Super::Deinitialize();
+}
+
+void UPickupRegistrySubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (!bActive)
+		return;
+
+	UInteractionSubsystem* InteractionSubsystem = InWorld.GetSubsystem<UInteractionSubsystem>();
+
+	// Register the pickups that are placed in the level
+	for (TActorIterator<AActor> It(&InWorld); It; ++It)
+	{
+		const EInteractionType Type = InteractionSubsystem->GetInteractionType(*It);
+
+		if (Type == EInteractionType::Coin || (Type == EInteractionType::Recharge && !It->IsHidden()))
+			Register(*It, Type);
+	}
+
+	UE_LOG(LogTheLab, Log, TEXT("Pickup registry active with %d pickups in %d cells"), ActorToSlot.Num(), Cells.Num());
+}
+
+void UPickupRegistrySubsystem::Tick(float DeltaTime)
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_PickupQuery);
+
+	ACharacter* Collector = CollectorCharacter.Get();
+
+	if (!Collector)
+		return;
+
+	// The capsule as a vertical segment with a radius
+	const UCapsuleComponent* Capsule = Collector->GetCapsuleComponent();
+	const FVector Center = Capsule->GetComponentLocation();
+	const float CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+	const float SegmentHalfLength = Capsule->GetScaledCapsuleHalfHeight() - CapsuleRadius;
+
+	const FVector SegmentStart = Center - FVector(0.0f, 0.0f, SegmentHalfLength);
+	const FVector SegmentEnd = Center + FVector(0.0f, 0.0f, SegmentHalfLength);
+
+	// Cells that can contain a pickup touching the capsule
+	const float QueryRadius = CapsuleRadius + MaxRadius;
+	const FIntPoint MinCell = GetCell(Center - FVector(QueryRadius, QueryRadius, 0.0f));
+	const FIntPoint MaxCell = GetCell(Center + FVector(QueryRadius, QueryRadius, 0.0f));
+
+	CollectedSlots.Reset();
+
+	for (int32 CellX = MinCell.X; CellX <= MaxCell.X; CellX++)
+	{
+		for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; CellY++)
+		{
+			const TArray<int32>* Slots = Cells.Find(FIntPoint(CellX, CellY));
+
+			if (!Slots)
+				continue;
+
+			for (const int32 Slot : *Slots)
+			{
+				const float TouchDistance = CapsuleRadius + Radii[Slot];
+				const FVector ClosestPoint = FMath::ClosestPointOnSegment(Positions[Slot], SegmentStart, SegmentEnd);
+
+				if (FVector::DistSquared(ClosestPoint, Positions[Slot]) <= TouchDistance * TouchDistance)
+					CollectedSlots.Emplace(Slot, Actors[Slot]);
+			}
+		}
+	}
+
+	// Dispatch after the query, the callback is allowed to change the registry
+	for (const TPair<int32, TObjectKey<AActor>>& Collected : CollectedSlots)
+	{
+		const int32 Slot = Collected.Key;
+
+		// The callback of an earlier pickup unregistered this one (and a registered pickup may have reused the slot)
+		if (Actors[Slot] != Collected.Value)
+			continue;
+
+		AActor* Pickup = Actors[Slot].ResolveObjectPtr();
+		const EInteractionType Type = Types[Slot];
+
+		RemoveSlot(Slot);
+
+		if (Pickup)
+			OnPickupCollected.ExecuteIfBound(Pickup, Type);
+	}
+}
+
+bool UPickupRegistrySubsystem::IsTickable() const
+{
+	return bActive && CollectorCharacter.IsValid() && ActorToSlot.Num() > 0;
+}
+
+TStatId UPickupRegistrySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPickupRegistrySubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UPickupRegistrySubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void UPickupRegistrySubsystem::Register(AActor* Pickup, EInteractionType Type)
+{
+	if (!bActive || !Pickup || ActorToSlot.Contains(Pickup))
+		return;
+
+	const float Radius = Pickup->GetSimpleCollisionRadius();
+
+	int32 Slot;
+
+	if (FreeSlots.Num() > 0)
+	{
+		Slot = FreeSlots.Pop(false);
+
+		Positions[Slot] = Pickup->GetActorLocation();
+		Radii[Slot] = Radius;
+		Types[Slot] = Type;
+		Actors[Slot] = Pickup;
+	}
+	else
+	{
+		Slot = Positions.Add(Pickup->GetActorLocation());
+		Radii.Add(Radius);
+		Types.Add(Type);
+		Actors.Add(Pickup);
+	}
+
+	ActorToSlot.Add(Pickup, Slot);
+	Cells.FindOrAdd(GetCell(Positions[Slot])).Add(Slot);
+
+	MaxRadius = FMath::Max(MaxRadius, Radius);
+
+	SET_DWORD_STAT(STAT_TheLab_RegisteredPickups, ActorToSlot.Num());
+
+	// The registry does the collecting, so the pickup doesn't need to be in the broadphase
+	Pickup->SetActorEnableCollision(false);
+}
+
+void UPickupRegistrySubsystem::Unregister(AActor* Pickup)
+{
+	if (const int32* Slot = ActorToSlot.Find(Pickup))
+		RemoveSlot(*Slot);
+}
+
+void UPickupRegistrySubsystem::SetCollector(ACharacter* Collector, FOnPickupCollected OnCollected)
+{
+	CollectorCharacter = Collector;
+	OnPickupCollected = OnCollected;
+}
+
+void UPickupRegistrySubsystem::ClearCollector(ACharacter* Collector)
+{
+	if (CollectorCharacter.Get() == Collector)
+	{
+		CollectorCharacter.Reset();
+		OnPickupCollected.Unbind();
+	}
+}
+
+FIntPoint UPickupRegistrySubsystem::GetCell(const FVector& Position) const
+{
+	return FIntPoint(FMath::FloorToInt(Position.X / CellSize), FMath::FloorToInt(Position.Y / CellSize));
+}
+
+void UPickupRegistrySubsystem::RemoveSlot(int32 Slot)
+{
+	const FIntPoint Cell = GetCell(Positions[Slot]);
+
+	if (TArray<int32>* Slots = Cells.Find(Cell))
+	{
+		Slots->RemoveSwap(Slot, false);
+
+		if (Slots->Num() == 0)
+			Cells.Remove(Cell);
+	}
+
+	ActorToSlot.Remove(Actors[Slot]);
+	Actors[Slot] = TObjectKey<AActor>();
+	FreeSlots.Add(Slot);
+
+	SET_DWORD_STAT(STAT_TheLab_RegisteredPickups, ActorToSlot.Num());
+}
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "GameFramework/Character.h"
+
+#include "InteractionSubsystem.h"
+
+#include "PickupRegistrySubsystem.generated.h"
+
+// Called for every pickup the collector touches
+DECLARE_DELEGATE_TwoParams(FOnPickupCollected, AActor* /*Pickup*/, EInteractionType /*Type*/);
+
+/**
+ * Stores all pickups of the world in flat arrays bucketed in a uniform grid,
+ * and collects them with one proximity query per frame against the collector's capsule.
+ * Replaces the per-pickup overlap events when thelab.Pickups.UseRegistry is enabled at level start.
+ */
+UCLASS()
+class PP_TERM4_API UPickupRegistrySubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	// Returns true when pickups in this world are collected by the registry instead of overlap events
+	bool IsActive() const { return bActive; }
+
+	// Adds the pickup to the registry and turns off its collision
+	void Register(AActor* Pickup, EInteractionType Type);
+	void Unregister(AActor* Pickup);
+
+	bool IsRegistered(const AActor* Pickup) const { return ActorToSlot.Contains(Pickup); }
+
+	// Sets the character whose capsule collects the pickups
+	void SetCollector(ACharacter* Collector, FOnPickupCollected OnCollected);
+	void ClearCollector(ACharacter* Collector);
+
+	int32 GetNumPickups() const { return ActorToSlot.Num(); }
+
+private:
+	FIntPoint GetCell(const FVector& Position) const;
+
+	void RemoveSlot(int32 Slot);
+
+	// Registry state (read from the console variable when the world is created)
+	bool bActive;
+	float CellSize;
+
+	// Pickup data, one entry per slot
+	TArray<FVector> Positions;
+	TArray<float> Radii;
+	TArray<EInteractionType> Types;
+	TArray<TObjectKey<AActor>> Actors;
+
+	// Slots that can be reused
+	TArray<int32> FreeSlots;
+
+	TMap<TObjectKey<AActor>, int32> ActorToSlot;
+
+	// Uniform spatial hash (cell to slots)
+	TMap<FIntPoint, TArray<int32>> Cells;
+
+	// Largest pickup radius, used to widen the query
+	float MaxRadius;
+
+	// Collector
+	TWeakObjectPtr<ACharacter> CollectorCharacter;
+	FOnPickupCollected OnPickupCollected;
+
+	// Slots touched this frame, and the pickup that was in the slot
+	TArray<TPair<int32, TObjectKey<AActor>>> CollectedSlots;
+};
@@ -0,0 +1,271 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PickupSignificanceSubsystem.h"
+#include "PP_Term4.h"
+#include "InteractableComponent.h"
+#include "InteractionSubsystem.h"
+#include "TheLabStats.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/RotatingMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "SignificanceManager.h"
+
+static TAutoConsoleVariable<bool> CVarSignificanceEnable(
+	TEXT("thelab.Significance.Enable"),
+	true,
+	TEXT("Throttles the ticks, idle animation and overlap events of interactables that matter little to the player.\n")
+	TEXT("Read when a level starts."));
+
+static TAutoConsoleVariable<float> CVarSignificanceNearDistance(
+	TEXT("thelab.Significance.NearDistance"),
+	1500.0f,
+	TEXT("Interactables closer to the player than this run at full rate (in cm)."));
+
+static TAutoConsoleVariable<float> CVarSignificanceFarDistance(
+	TEXT("thelab.Significance.FarDistance"),
+	6000.0f,
+	TEXT("Interactables that were rendered recently and are closer than this are medium significance (in cm)."));
+
+static TAutoConsoleVariable<float> CVarSignificanceMediumTickInterval(
+	TEXT("thelab.Significance.MediumTickInterval"),
+	0.1f,
+	TEXT("Tick interval of medium significance interactables (in seconds)."));
+
+static TAutoConsoleVariable<float> CVarSignificanceLowTickInterval(
+	TEXT("thelab.Significance.LowTickInterval"),
+	0.5f,
+	TEXT("Tick interval of low significance interactables (in seconds)."));
+
+// Console command to print the tier counts of the current world
+static FAutoConsoleCommandWithWorld GSignificanceStatsCommand(
+	TEXT("thelab.Significance.Stats"),
+	TEXT("Logs how many interactables are in every significance tier in the current world."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UPickupSignificanceSubsystem* Significance = World ? World->GetSubsystem<UPickupSignificanceSubsystem>() : nullptr)
+			Significance->LogStats();
+	}));
+
+static const FName SignificanceTag(TEXT("TheLab.Interactable"));
+
+void UPickupSignificanceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FMemory::Memzero(TierCounts);
+}
+
+void UPickupSignificanceSubsystem::Deinitialize()
+{
+	if (USignificanceManager* SignificanceManager = FSignificanceManagerModule::Get(GetWorld()))
+		SignificanceManager->UnregisterAll(SignificanceTag);
+
+	if (ActorSpawnedHandle.IsValid())
+		GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+
+	Actors.Empty();
+
+	Super::Deinitialize();
+}
+
+void UPickupSignificanceSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (!CVarSignificanceEnable.GetValueOnGameThread())
+		return;
+
+	if (!FSignificanceManagerModule::Get(&InWorld))
+	{
+		UE_LOG(LogTheLab, Warning, TEXT("No significance manager in %s, interactables run at full rate"), *InWorld.GetMapName());
+		return;
+	}
+
+	// Placed interactables, and the ones spawned later on
+	for (TActorIterator<AActor> It(&InWorld); It; ++It)
+		OnActorSpawned(*It);
+
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UPickupSignificanceSubsystem::OnActorSpawned));
+
+	UE_LOG(LogTheLab, Log, TEXT("Significance of %d interactables managed"), Actors.Num());
+}
+
+void UPickupSignificanceSubsystem::Tick(float DeltaTime)
+{
+	USignificanceManager* SignificanceManager = FSignificanceManagerModule::Get(GetWorld());
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+
+	if (!SignificanceManager || !Pawn)
+		return;
+
+	// Ranks every interactable from the possessed pawn, the tier changes are applied in the post significance function
+	const FTransform Viewpoint = Pawn->GetActorTransform();
+	SignificanceManager->Update(MakeArrayView(&Viewpoint, 1));
+
+	SET_DWORD_STAT(STAT_TheLab_SignificanceHigh, TierCounts[(uint8)ESignificanceTier::High]);
+	SET_DWORD_STAT(STAT_TheLab_SignificanceMedium, TierCounts[(uint8)ESignificanceTier::Medium]);
+	SET_DWORD_STAT(STAT_TheLab_SignificanceLow, TierCounts[(uint8)ESignificanceTier::Low]);
+}
+
+bool UPickupSignificanceSubsystem::IsTickable() const
+{
+	return Actors.Num() > 0;
+}
+
+TStatId UPickupSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPickupSignificanceSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UPickupSignificanceSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void UPickupSignificanceSubsystem::Register(AActor* Actor)
+{
+	USignificanceManager* SignificanceManager = FSignificanceManagerModule::Get(GetWorld());
+
+	if (!Actor || !SignificanceManager || Actors.Contains(Actor))
+		return;
+
+	// Remember what the tiers change, so the full rate can be restored
+	FSignificantActor& State = Actors.Add(Actor);
+	State.ActorTickInterval = Actor->GetActorTickInterval();
+
+	for (UActorComponent* Component : Actor->GetComponents())
+	{
+		if (!Component)
+			continue;
+
+		if (Component->PrimaryComponentTick.bCanEverTick)
+			State.ComponentTickIntervals.Emplace(Component, Component->GetComponentTickInterval());
+
+		if (UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component))
+		{
+			if (Primitive->GetGenerateOverlapEvents())
+				State.OverlapComponents.Add(Primitive);
+		}
+		else if (URotatingMovementComponent* RotatingMovement = Cast<URotatingMovementComponent>(Component))
+			State.RotationRates.Emplace(RotatingMovement, RotatingMovement->RotationRate);
+	}
+
+	TierCounts[(uint8)State.Tier]++;
+
+	Actor->OnEndPlay.AddDynamic(this, &UPickupSignificanceSubsystem::OnActorEndPlay);
+
+	SignificanceManager->RegisterObject(Actor, SignificanceTag,
+		[](USignificanceManager::FManagedObjectInfo* ObjectInfo, const FTransform& Viewpoint)
+		{
+			return CalculateSignificance(Cast<AActor>(ObjectInfo->GetObject()), Viewpoint);
+		},
+		USignificanceManager::EPostSignificanceType::Sequential,
+		[this](USignificanceManager::FManagedObjectInfo* ObjectInfo, float OldSignificance, float Significance, bool bFinal)
+		{
+			if (AActor* SignificantActor = Cast<AActor>(ObjectInfo->GetObject()))
+				ApplyTier(SignificantActor, (ESignificanceTier)FMath::RoundToInt(Significance));
+		});
+}
+
+void UPickupSignificanceSubsystem::Unregister(AActor* Actor)
+{
+	if (!Actor || !Actors.Contains(Actor))
+		return;
+
+	if (USignificanceManager* SignificanceManager = FSignificanceManagerModule::Get(GetWorld()))
+		SignificanceManager->UnregisterObject(Actor);
+
+	ApplyTier(Actor, ESignificanceTier::High);
+	TierCounts[(uint8)ESignificanceTier::High]--;
+
+	Actor->OnEndPlay.RemoveDynamic(this, &UPickupSignificanceSubsystem::OnActorEndPlay);
+	Actors.Remove(Actor);
+}
+
+void UPickupSignificanceSubsystem::LogStats() const
+{
+	UE_LOG(LogTheLab, Log, TEXT("Significance: %d high, %d medium, %d low"),
+		TierCounts[(uint8)ESignificanceTier::High], TierCounts[(uint8)ESignificanceTier::Medium], TierCounts[(uint8)ESignificanceTier::Low]);
+}
+
+void UPickupSignificanceSubsystem::OnActorSpawned(AActor* Actor)
+{
+	// Everything the player can interact with (pickups, game colliders, the end)
+	if (Actor && (Actor->Tags.Num() > 0 || Actor->FindComponentByClass<UInteractableComponent>())
+		&& GetWorld()->GetSubsystem<UInteractionSubsystem>()->GetInteractionType(Actor) != EInteractionType::None)
+		Register(Actor);
+}
+
+void UPickupSignificanceSubsystem::OnActorEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	Unregister(Actor);
+}
+
+float UPickupSignificanceSubsystem::CalculateSignificance(const AActor* Actor, const FTransform& Viewpoint)
+{
+	if (!Actor)
+		return (float)ESignificanceTier::Low;
+
+	const float NearDistance = CVarSignificanceNearDistance.GetValueOnGameThread();
+	const float FarDistance = CVarSignificanceFarDistance.GetValueOnGameThread();
+	const float DistanceSquared = FVector::DistSquared(Actor->GetActorLocation(), Viewpoint.GetLocation());
+
+	// Close by counts regardless of visibility, the player can walk into it behind the camera
+	if (DistanceSquared < NearDistance * NearDistance)
+		return (float)ESignificanceTier::High;
+
+	if (DistanceSquared < FarDistance * FarDistance && Actor->WasRecentlyRendered(0.25f))
+		return (float)ESignificanceTier::Medium;
+
+	return (float)ESignificanceTier::Low;
+}
+
+void UPickupSignificanceSubsystem::ApplyTier(AActor* Actor, ESignificanceTier Tier)
+{
+	FSignificantActor* State = Actors.Find(Actor);
+
+	if (!State || State->Tier == Tier)
+		return;
+
+	TierCounts[(uint8)State->Tier]--;
+	TierCounts[(uint8)Tier]++;
+	State->Tier = Tier;
+
+	// Ticks
+	const float TierInterval = Tier == ESignificanceTier::High ? 0.0f :
+		Tier == ESignificanceTier::Medium ? CVarSignificanceMediumTickInterval.GetValueOnGameThread() : CVarSignificanceLowTickInterval.GetValueOnGameThread();
+
+	Actor->SetActorTickInterval(FMath::Max(State->ActorTickInterval, TierInterval));
+
+	for (const TPair<TWeakObjectPtr<UActorComponent>, float>& Pair : State->ComponentTickIntervals)
+	{
+		if (UActorComponent* Component = Pair.Key.Get())
+			Component->SetComponentTickInterval(FMath::Max(Pair.Value, TierInterval));
+	}
+
+	// Overlap events and idle animation
+	const bool bLow = Tier == ESignificanceTier::Low;
+
+	for (const TWeakObjectPtr<UPrimitiveComponent>& Primitive : State->OverlapComponents)
+	{
+		if (Primitive.IsValid())
+			Primitive->SetGenerateOverlapEvents(!bLow);
+	}
+
+	TInlineComponentArray<USkeletalMeshComponent*> SkeletalMeshes(Actor);
+
+	for (USkeletalMeshComponent* SkeletalMesh : SkeletalMeshes)
+		SkeletalMesh->bPauseAnims = bLow;
+
+	for (const TPair<TWeakObjectPtr<URotatingMovementComponent>, FRotator>& Pair : State->RotationRates)
+	{
+		if (URotatingMovementComponent* RotatingMovement = Pair.Key.Get())
+			RotatingMovement->RotationRate = bLow ? FRotator::ZeroRotator : Pair.Value;
+	}
+}
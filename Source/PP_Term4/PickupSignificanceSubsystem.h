@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "GameFramework/Actor.h"
+
+#include "PickupSignificanceSubsystem.generated.h"
+
+class UPrimitiveComponent;
+class URotatingMovementComponent;
+
+// How much an interactable matters to the player
+UENUM()
+enum class ESignificanceTier : uint8
+{
+	Low,		// Far away: slow ticks, paused idle animation, no overlap events
+	Medium,		// Visible but not close: slower ticks
+	High,		// Close to the player: full rate
+
+	MAX UMETA(Hidden)
+};
+
+/**
+ * Ranks the pickups and interactables (every actor with an interaction type) with the significance manager,
+ * by the distance to the possessed pawn and whether they were rendered recently.
+ * Lower tiers get longer tick intervals, and the lowest tier pauses idle animation and overlap events,
+ * so the cost of a level follows what is around the player instead of its size.
+ * Actors only get overlap events turned off beyond thelab.Significance.NearDistance, where they can't be touched this frame.
+ */
+UCLASS()
+class PP_TERM4_API UPickupSignificanceSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	void Register(AActor* Actor);
+	void Unregister(AActor* Actor);
+
+	int32 GetTierCount(ESignificanceTier Tier) const { return TierCounts[(uint8)Tier]; }
+
+	void LogStats() const;
+
+private:
+	// State of the actor when it was registered, restored when it goes back up
+	struct FSignificantActor
+	{
+		ESignificanceTier Tier = ESignificanceTier::High;
+
+		float ActorTickInterval = 0.0f;
+		TArray<TPair<TWeakObjectPtr<UActorComponent>, float>> ComponentTickIntervals;
+
+		// Primitives that generated overlap events
+		TArray<TWeakObjectPtr<UPrimitiveComponent>> OverlapComponents;
+
+		// Idle spin
+		TArray<TPair<TWeakObjectPtr<URotatingMovementComponent>, FRotator>> RotationRates;
+	};
+
+	void OnActorSpawned(AActor* Actor);
+
+	UFUNCTION()
+		void OnActorEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+
+	static float CalculateSignificance(const AActor* Actor, const FTransform& Viewpoint);
+	void ApplyTier(AActor* Actor, ESignificanceTier Tier);
+
+	TMap<TObjectKey<AActor>, FSignificantActor> Actors;
+
+	int32 TierCounts[(uint8)ESignificanceTier::MAX];
+
+	FDelegateHandle ActorSpawnedHandle;
+};
@@ -0,0 +1,390 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PickupSwarmSubsystem.h"
+#include "PP_Term4.h"
+#include "InputReplaySubsystem.h"
+#include "TheLabStats.h"
+#include "Async/ParallelFor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarSwarmCount(
+	TEXT("thelab.Swarm.Count"),
+	0,
+	TEXT("Amount of stress pickups spawned around the player when a level starts (0 = off).\n")
+	TEXT("Read when a level starts."));
+
+static TAutoConsoleVariable<int32> CVarSwarmWorkers(
+	TEXT("thelab.Swarm.Workers"),
+	0,
+	TEXT("Amount of threads the pickup passes are split over (0 = every task graph worker, 1 = game thread only)."));
+
+static TAutoConsoleVariable<bool> CVarSwarmAnimate(
+	TEXT("thelab.Swarm.Animate"),
+	true,
+	TEXT("Spins and bobs the stress pickups on the CPU every frame (0 = they stand still)."));
+
+static TAutoConsoleVariable<float> CVarSwarmSpacing(
+	TEXT("thelab.Swarm.Spacing"),
+	150.0f,
+	TEXT("Distance between two stress pickups (in cm). Read when they are spawned."));
+
+static TAutoConsoleVariable<FString> CVarSwarmMesh(
+	TEXT("thelab.Swarm.Mesh"),
+	TEXT("/Engine/BasicShapes/Cylinder.Cylinder"),
+	TEXT("Mesh of the stress pickups. Read when they are spawned."));
+
+// Console commands to spawn the swarm and print its timings
+static FAutoConsoleCommandWithWorldAndArgs GSwarmSpawnCommand(
+	TEXT("thelab.Swarm.Spawn"),
+	TEXT("Replaces the stress pickups with the amount around the player. Usage: thelab.Swarm.Spawn [Count] (0 = clear)"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UPickupSwarmSubsystem* Swarm = World ? World->GetSubsystem<UPickupSwarmSubsystem>() : nullptr;
+		APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+		APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+
+		if (!Swarm || !Pawn)
+		{
+			UE_LOG(LogTheLab, Warning, TEXT("thelab.Swarm.Spawn needs a possessed pawn"));
+			return;
+		}
+
+		Swarm->SpawnPickups(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000, Pawn->GetActorLocation());
+	}));
+
+static FAutoConsoleCommandWithWorld GSwarmStatsCommand(
+	TEXT("thelab.Swarm.Stats"),
+	TEXT("Logs the average time of the stress pickup passes since the last call."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UPickupSwarmSubsystem* Swarm = World ? World->GetSubsystem<UPickupSwarmSubsystem>() : nullptr)
+			Swarm->LogStats();
+	}));
+
+// Pickup shape and idle animation
+static const float SwarmPickupRadius = 40.0f;
+static const FVector SwarmPickupScale(0.4f, 0.4f, 0.05f);
+static const float SwarmSpinSpeed = 180.0f;		// Degrees per second
+static const float SwarmBobHeight = 10.0f;
+static const float SwarmBobFrequency = 0.5f;
+
+// Every tenth pickup is a recharge, the others are coins
+static const int32 SwarmRechargeEvery = 10;
+
+// Pawn that collects the pickups
+struct FSwarmCollector
+{
+	FVector Location;
+	float Radius;
+	float HalfHeight;
+};
+
+void UPickupSwarmSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Instances = nullptr;
+	bInstancesDirty = false;
+	NumCollected = 0;
+	PendingCount = 0;
+
+	FMemory::Memzero(CollectedByType);
+
+	AnimateSeconds = 0.0;
+	CollectSeconds = 0.0;
+	UploadSeconds = 0.0;
+	NumTimedFrames = 0;
+}
+
+void UPickupSwarmSubsystem::Deinitialize()
+{
+	ClearPickups();
+
+	Super::Deinitialize();
+}
+
+void UPickupSwarmSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// The player isn't spawned yet, the swarm is centered on it once it is
+	if (InWorld.IsGameWorld())
+		PendingCount = FMath::Max(CVarSwarmCount.GetValueOnGameThread(), 0);
+}
+
+void UPickupSwarmSubsystem::Tick(float DeltaTime)
+{
+	if (PendingCount > 0)
+	{
+		const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+		const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+
+		if (!Pawn)
+			return;
+
+		SpawnPickups(PendingCount, Pawn->GetActorLocation());
+		PendingCount = 0;
+	}
+
+	if (!Instances)
+		return;
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	if (CVarSwarmAnimate.GetValueOnGameThread())
+		AnimatePickups(GetWorld()->GetTimeSeconds());
+
+	const uint64 AnimateCycles = FPlatformTime::Cycles64();
+
+	CollectPickups();
+
+	const uint64 CollectCycles = FPlatformTime::Cycles64();
+
+	UploadInstances();
+
+	const uint64 UploadCycles = FPlatformTime::Cycles64();
+
+	AnimateSeconds += FPlatformTime::ToSeconds64(AnimateCycles - StartCycles);
+	CollectSeconds += FPlatformTime::ToSeconds64(CollectCycles - AnimateCycles);
+	UploadSeconds += FPlatformTime::ToSeconds64(UploadCycles - CollectCycles);
+	NumTimedFrames++;
+}
+
+bool UPickupSwarmSubsystem::IsTickable() const
+{
+	return PendingCount > 0 || Instances != nullptr;
+}
+
+TStatId UPickupSwarmSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPickupSwarmSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UPickupSwarmSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void UPickupSwarmSubsystem::SpawnPickups(int32 Count, const FVector& Center)
+{
+	ClearPickups();
+
+	if (Count <= 0)
+		return;
+
+	UStaticMesh* Mesh = LoadObject<UStaticMesh>(nullptr, *CVarSwarmMesh.GetValueOnGameThread());
+
+	if (!Mesh)
+	{
+		UE_LOG(LogTheLab, Warning, TEXT("Stress pickup mesh %s not found"), *CVarSwarmMesh.GetValueOnGameThread());
+		return;
+	}
+
+	// A square grid around the center, jittered so it doesn't look like one
+	const float Spacing = FMath::Max(CVarSwarmSpacing.GetValueOnGameThread(), 1.0f);
+	const int32 Side = FMath::CeilToInt(FMath::Sqrt((float)Count));
+	const FVector Origin = Center - FVector(Side * Spacing * 0.5f, Side * Spacing * 0.5f, 0.0f);
+
+	FRandomStream Random(UInputReplaySubsystem::GetRandomSeed(this));
+
+	Positions.SetNumUninitialized(Count);
+	Types.SetNumUninitialized(Count);
+	States.Init(ESwarmPickupState::Idle, Count);
+	Phases.SetNumUninitialized(Count);
+	InstanceTransforms.SetNumUninitialized(Count);
+
+	for (int32 Index = 0; Index < Count; Index++)
+	{
+		const FVector Jitter(Random.FRandRange(-0.25f, 0.25f) * Spacing, Random.FRandRange(-0.25f, 0.25f) * Spacing, 0.0f);
+
+		Positions[Index] = Origin + FVector((Index % Side) * Spacing, (Index / Side) * Spacing, 0.0f) + Jitter;
+		Types[Index] = Index % SwarmRechargeEvery == 0 ? EInteractionType::Recharge : EInteractionType::Coin;
+		Phases[Index] = Random.GetFraction();
+		InstanceTransforms[Index] = FTransform(FRotator(0.0f, Phases[Index] * 360.0f, 90.0f), Positions[Index], SwarmPickupScale);
+	}
+
+	// Drawn only, the collection pass replaces the physics bodies
+	UWorld* World = GetWorld();
+
+	Instances = NewObject<UInstancedStaticMeshComponent>(World->GetWorldSettings());
+	Instances->SetStaticMesh(Mesh);
+	Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Instances->SetCanEverAffectNavigation(false);
+	Instances->SetCastShadow(false);
+	Instances->SetMobility(EComponentMobility::Movable);
+	Instances->RegisterComponentWithWorld(World);
+	Instances->AddInstances(InstanceTransforms, false, true);
+
+	SET_DWORD_STAT(STAT_TheLab_SwarmPickups, Count);
+
+	UE_LOG(LogTheLab, Log, TEXT("Spawned %d stress pickups, passes split in %d chunks on %d worker threads"),
+		Count, GetNumChunks(), FTaskGraphInterface::Get().GetNumWorkerThreads());
+}
+
+void UPickupSwarmSubsystem::ClearPickups()
+{
+	if (Instances)
+	{
+		Instances->DestroyComponent();
+		Instances = nullptr;
+	}
+
+	Positions.Empty();
+	Types.Empty();
+	States.Empty();
+	Phases.Empty();
+	InstanceTransforms.Empty();
+	ChunkCollected.Empty();
+
+	bInstancesDirty = false;
+	NumCollected = 0;
+	FMemory::Memzero(CollectedByType);
+
+	SET_DWORD_STAT(STAT_TheLab_SwarmPickups, 0);
+}
+
+void UPickupSwarmSubsystem::LogStats()
+{
+	const double Frames = FMath::Max(NumTimedFrames, 1);
+
+	UE_LOG(LogTheLab, Log, TEXT("Swarm: %d pickups, %d collected (%d coins, %d recharges), %d chunks, %d worker threads"),
+		Positions.Num(), NumCollected, CollectedByType[(uint8)EInteractionType::Coin], CollectedByType[(uint8)EInteractionType::Recharge],
+		GetNumChunks(), FTaskGraphInterface::Get().GetNumWorkerThreads());
+
+	UE_LOG(LogTheLab, Log, TEXT("Swarm passes over %d frames: animate %.3f ms, collect %.3f ms, upload %.3f ms"),
+		NumTimedFrames, AnimateSeconds * 1000.0 / Frames, CollectSeconds * 1000.0 / Frames, UploadSeconds * 1000.0 / Frames);
+
+	AnimateSeconds = 0.0;
+	CollectSeconds = 0.0;
+	UploadSeconds = 0.0;
+	NumTimedFrames = 0;
+}
+
+int32 UPickupSwarmSubsystem::GetNumChunks() const
+{
+	const int32 Workers = CVarSwarmWorkers.GetValueOnGameThread();
+
+	// A few chunks per thread so a slow worker doesn't hold up the pass
+	return Workers > 0 ? Workers : (FTaskGraphInterface::Get().GetNumWorkerThreads() + 1) * 4;
+}
+
+void UPickupSwarmSubsystem::AnimatePickups(float Time)
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_SwarmAnimate);
+
+	const int32 NumPickups = Positions.Num();
+	const int32 NumChunks = FMath::Min(GetNumChunks(), NumPickups);
+	const int32 ChunkSize = FMath::DivideAndRoundUp(NumPickups, NumChunks);
+
+	// Every chunk writes its own range of the transforms
+	ParallelFor(NumChunks, [this, Time, NumPickups, ChunkSize](int32 Chunk)
+	{
+		const int32 End = FMath::Min((Chunk + 1) * ChunkSize, NumPickups);
+
+		for (int32 Index = Chunk * ChunkSize; Index < End; Index++)
+		{
+			if (States[Index] != ESwarmPickupState::Idle)
+				continue;
+
+			const float Bob = FMath::Sin((Time * SwarmBobFrequency + Phases[Index]) * 2.0f * PI) * SwarmBobHeight;
+
+			InstanceTransforms[Index].SetRotation(FQuat(FRotator(0.0f, Time * SwarmSpinSpeed + Phases[Index] * 360.0f, 90.0f)));
+			InstanceTransforms[Index].SetTranslation(Positions[Index] + FVector(0.0f, 0.0f, Bob));
+		}
+	}, NumChunks == 1);
+
+	bInstancesDirty = true;
+}
+
+void UPickupSwarmSubsystem::CollectPickups()
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_SwarmCollect);
+
+	// Every possessed pawn collects, as a cylinder
+	TArray<FSwarmCollector, TInlineAllocator<4>> Collectors;
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APawn* Pawn = It->Get() ? It->Get()->GetPawn() : nullptr;
+
+		if (!Pawn)
+			continue;
+
+		FSwarmCollector& Collector = Collectors.AddDefaulted_GetRef();
+		Collector.Location = Pawn->GetActorLocation();
+
+		Pawn->GetSimpleCollisionCylinder(Collector.Radius, Collector.HalfHeight);
+		Collector.Radius += SwarmPickupRadius;
+		Collector.HalfHeight += SwarmPickupRadius;
+	}
+
+	if (Collectors.Num() == 0)
+		return;
+
+	const int32 NumPickups = Positions.Num();
+	const int32 NumChunks = FMath::Min(GetNumChunks(), NumPickups);
+	const int32 ChunkSize = FMath::DivideAndRoundUp(NumPickups, NumChunks);
+
+	ChunkCollected.SetNum(NumChunks);
+
+	// Chunks only read the pickups and write their own list
+	ParallelFor(NumChunks, [this, &Collectors, NumPickups, ChunkSize](int32 Chunk)
+	{
+		TArray<int32>& Collected = ChunkCollected[Chunk];
+		Collected.Reset();
+
+		const int32 End = FMath::Min((Chunk + 1) * ChunkSize, NumPickups);
+
+		for (int32 Index = Chunk * ChunkSize; Index < End; Index++)
+		{
+			if (States[Index] != ESwarmPickupState::Idle)
+				continue;
+
+			const FVector& Position = Positions[Index];
+
+			for (const FSwarmCollector& Collector : Collectors)
+			{
+				const float DistanceSquared = FVector::DistSquared2D(Position, Collector.Location);
+
+				if (DistanceSquared <= Collector.Radius * Collector.Radius && FMath::Abs(Position.Z - Collector.Location.Z) <= Collector.HalfHeight)
+				{
+					Collected.Add(Index);
+					break;
+				}
+			}
+		}
+	}, NumChunks == 1);
+
+	// Applied on the game thread, a zero scale hides the instance
+	for (const TArray<int32>& Collected : ChunkCollected)
+	{
+		for (const int32 Index : Collected)
+		{
+			States[Index] = ESwarmPickupState::Collected;
+			InstanceTransforms[Index].SetScale3D(FVector::ZeroVector);
+
+			CollectedByType[(uint8)Types[Index]]++;
+			NumCollected++;
+			bInstancesDirty = true;
+		}
+	}
+}
+
+void UPickupSwarmSubsystem::UploadInstances()
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_SwarmUpload);
+
+	if (!bInstancesDirty)
+		return;
+
+	// One batch for every instance, the render data is rebuilt once
+	Instances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, false);
+	bInstancesDirty = false;
+}
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+
+#include "InteractionSubsystem.h"
+
+#include "PickupSwarmSubsystem.generated.h"
+
+class UInstancedStaticMeshComponent;
+
+enum class ESwarmPickupState : uint8
+{
+	Idle,
+	Collected
+};
+
+/**
+ * Stress mode for very large amounts of pickups (10k - 100k), which are data instead of actors.
+ * Every pickup is an index into flat arrays (position, type, state, phase), the idle animation and the proximity
+ * collection run as passes over those arrays in parallel chunks on the task graph workers, and the pickups are drawn
+ * as instances of one mesh. Spawned with thelab.Swarm.Count at level start or thelab.Swarm.Spawn at any time,
+ * thelab.Swarm.Workers limits the amount of chunks to measure how the frame time scales with the cores.
+ */
+UCLASS()
+class PP_TERM4_API UPickupSwarmSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	// Replaces the swarm with the amount of pickups in a square around the location
+	void SpawnPickups(int32 Count, const FVector& Center);
+	void ClearPickups();
+
+	int32 GetNumPickups() const { return Positions.Num(); }
+	int32 GetNumCollected() const { return NumCollected; }
+
+	void LogStats();
+
+private:
+	// Amount of chunks the passes are split into (one chunk runs on one thread)
+	int32 GetNumChunks() const;
+
+	// Passes
+	void AnimatePickups(float Time);
+	void CollectPickups();
+	void UploadInstances();
+
+	// Pickup data, one entry per pickup
+	TArray<FVector> Positions;
+	TArray<EInteractionType> Types;
+	TArray<ESwarmPickupState> States;
+	TArray<float> Phases;
+
+	// Representation, written by the animation and collection passes
+	TArray<FTransform> InstanceTransforms;
+
+	UPROPERTY()
+		UInstancedStaticMeshComponent* Instances;
+
+	bool bInstancesDirty;
+
+	// Indices collected by every chunk this frame
+	TArray<TArray<int32>> ChunkCollected;
+
+	int32 NumCollected;
+	int32 CollectedByType[(uint8)EInteractionType::MAX];
+
+	// Spawned on the first tick with a pawn (thelab.Swarm.Count)
+	int32 PendingCount;
+
+	// Timings since the last stats
+	double AnimateSeconds;
+	double CollectSeconds;
+	double UploadSeconds;
+	int32 NumTimedFrames;
+};
@@ -1,38 +1,127 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-
-#include "PlayerCharacter_GameMode.h"
-#include "GameFramework/Actor.h"
-
-APlayerCharacter_GameMode::APlayerCharacter_GameMode()
-{
-	PrimaryActorTick.bCanEverTick = true;	// Calls the tick function every frame every second
-}
-
-void APlayerCharacter_GameMode::BeginPlay()
-{
-	Super::BeginPlay();
-
-	// Call the function evert 2 till 5 seconds
-	FTimerHandle localHandler;
-	GetWorldTimerManager().SetTimer(localHandler, this, &APlayerCharacter_GameMode::SpawnPlayerRecharge, FMath::RandRange(2, 5), true);
-}
-
-void APlayerCharacter_GameMode::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-}
-
-void APlayerCharacter_GameMode::SpawnPlayerRecharge()
-{
-	// Get random coordinates
-	float RandX = FMath::RandRange(Spawn_X_Min, Spawn_X_Max);
-	float RandY = FMath::RandRange(Spawn_Y_Min, Spawn_Y_Max);
-
-	// Create spawn position and rotaion
-	FVector SpawnPosition = FVector(RandX, RandY, Spawn_Z);
-	FRotator SpawnRotation = FRotator(0.0f, 0.0f, 0.0f);
-
-	// Spawn object with given position and rotation
-	GetWorld()->SpawnActor(PlayerRecharge, &SpawnPosition, &SpawnRotation);
-}
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlayerCharacter_GameMode.h"
+#include "CollectPlayerState.h"
+#include "GameFramework/Actor.h"
+#include "InputReplaySubsystem.h"
+#include "PP_Term4.h"
+#include "PickupPoolSubsystem.h"
+#include "PickupRegistrySubsystem.h"
+#include "TheLabStats.h"
+
+APlayerCharacter_GameMode::APlayerCharacter_GameMode()
+{
+	PrimaryActorTick.bCanEverTick = true;	// Calls the tick function every frame every second
+
+	// Health and countdown of every player, replicated by the server
+	PlayerStateClass = ACollectPlayerState::StaticClass();
+}
+
+void APlayerCharacter_GameMode::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Seeded per world, so a replayed session spawns the same recharges
+	RechargeRandom.Initialize(UInputReplaySubsystem::GetRandomSeed(this));
+
+	// Load the recharge in the background, the spawns wait for it
+	RechargeAssets = UAssetPreloadSubsystem::Get(this)->Preload({ PlayerRecharge.ToSoftObjectPath() }, FOnAssetsPreloaded::CreateUObject(this, &APlayerCharacter_GameMode::OnRechargeLoaded), true);
+
+	// Bake the spawn points, the traces come back over the next frame
+	SpawnPointTraceDelegate.BindUObject(this, &APlayerCharacter_GameMode::OnSpawnPointTraced);
+	SpawnPoints.Build(GetWorld(), FBox2D(FVector2D(Spawn_X_Min, Spawn_Y_Min), FVector2D(Spawn_X_Max, Spawn_Y_Max)), Spawn_Z, SpawnCellSize, MaxFloorDistance, RechargeHalfHeight, SpawnPointTraceDelegate);
+
+	ScheduleNextSpawn();
+}
+
+void APlayerCharacter_GameMode::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+}
+
+void APlayerCharacter_GameMode::SpawnPlayerRecharge()
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_SpawnRecharge);
+
+	ScheduleNextSpawn();
+
+	// Wait until the spawn points are baked and the recharge is loaded
+	UClass* RechargeClass = PlayerRecharge.Get();
+
+	if (!SpawnPoints.IsBuilt() || !RechargeClass)
+		return;
+
+	PruneLiveRecharges();
+
+	if (LiveRecharges.Num() >= MaxLiveRecharges)
+		return;
+
+	// Take a free spawn point (none are free when every cell holds a recharge)
+	const int32 Cell = SpawnPoints.TakeRandom(RechargeRandom);
+
+	if (Cell == INDEX_NONE)
+		return;
+
+	// Create spawn position and rotaion
+	FVector SpawnPosition = SpawnPoints.GetLocation(Cell);
+	FRotator SpawnRotation = FRotator(0.0f, 0.0f, 0.0f);
+
+	// Activate a pooled object with given position and rotation
+	AActor* Recharge = GetWorld()->GetSubsystem<UPickupPoolSubsystem>()->Acquire(RechargeClass, SpawnPosition, SpawnRotation);
+
+	if (!Recharge)
+	{
+		SpawnPoints.Release(Cell);
+		return;
+	}
+
+	// The game mode only exists on the server, the clients see the recharges through replication
+	if (GetNetMode() != NM_Standalone)
+	{
+		Recharge->SetReplicates(true);
+		Recharge->SetReplicateMovement(true);
+	}
+
+	LiveRecharges.Add(Recharge, Cell);
+
+	// Hand it to the pickup registry when that does the collecting
+	GetWorld()->GetSubsystem<UPickupRegistrySubsystem>()->Register(Recharge, EInteractionType::Recharge);
+}
+
+void APlayerCharacter_GameMode::ScheduleNextSpawn()
+{
+	// Exponentially distributed waits make the spawns a Poisson process with the mean interval
+	const float Wait = -FMath::Loge(1.0f - RechargeRandom.GetFraction()) * MeanSpawnInterval;
+
+	GetWorldTimerManager().SetTimer(SpawnTimerHandle, this, &APlayerCharacter_GameMode::SpawnPlayerRecharge, FMath::Max(Wait, MinSpawnInterval), false);
+}
+
+void APlayerCharacter_GameMode::PruneLiveRecharges()
+{
+	UPickupPoolSubsystem* PickupPool = GetWorld()->GetSubsystem<UPickupPoolSubsystem>();
+
+	for (auto It = LiveRecharges.CreateIterator(); It; ++It)
+	{
+		const AActor* Recharge = It.Key().ResolveObjectPtr();
+
+		if (IsValid(Recharge) && PickupPool->IsActive(Recharge))
+			continue;
+
+		SpawnPoints.Release(It.Value());
+		It.RemoveCurrent();
+	}
+}
+
+void APlayerCharacter_GameMode::OnRechargeLoaded()
+{
+	// Create the recharges up front, so spawning one is only an activation
+	if (UClass* RechargeClass = PlayerRecharge.Get())
+		GetWorld()->GetSubsystem<UPickupPoolSubsystem>()->Prewarm(RechargeClass, PlayerRechargePoolPrewarm, PlayerRechargePoolMax);
+}
+
+void APlayerCharacter_GameMode::OnSpawnPointTraced(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	if (SpawnPoints.HandleTrace(TraceDatum) && SpawnPoints.GetNumPoints() == 0)
+		UE_LOG(LogTheLab, Warning, TEXT("No walkable spawn points for the recharges between the spawn coordinates"));
+}
@@ -1,45 +1,103 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "GameFramework/GameMode.h"
-#include "PlayerCharacter_GameMode.generated.h"
-
-/**
- *
- */
-UCLASS()
-class PP_TERM4_API APlayerCharacter_GameMode : public AGameMode
-{
-	GENERATED_BODY()
-
-		APlayerCharacter_GameMode();
-
-	virtual void BeginPlay() override;
-	virtual void Tick(float DeltaTime) override;
-
-public:
-	// Object to spawn
-	UPROPERTY(EditAnywhere, Category = "Spawn Object")
-		TSubclassOf<APawn> PlayerRecharge;
-
-	// Coordinates
-	UPROPERTY(EditAnywhere, Category = "Spawn Coordinates")
-		float Spawn_Z = 270.0f;
-
-	UPROPERTY(EditAnywhere, Category = "Spawn Coordinates")
-		float Spawn_X_Min;
-
-	UPROPERTY(EditAnywhere, Category = "Spawn Coordinates")
-		float Spawn_X_Max;
-
-	UPROPERTY(EditAnywhere, Category = "Spawn Coordinates")
-		float Spawn_Y_Min;
-
-	UPROPERTY(EditAnywhere, Category = "Spawn Coordinates")
-		float Spawn_Y_Max;
-
-private:
-	void SpawnPlayerRecharge();
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameMode.h"
+
+#include "AssetPreloadSubsystem.h"
+#include "SpawnPointGrid.h"
+
+#include "PlayerCharacter_GameMode.generated.h"
+
+/**
+ *
+ */
+UCLASS()
+class PP_TERM4_API APlayerCharacter_GameMode : public AGameMode
+{
+	GENERATED_BODY()
+
+		APlayerCharacter_GameMode();
+
+	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaTime) override;
+
+public:
+	// Object to spawn (soft, it is loaded in the background after BeginPlay)
+	UPROPERTY(EditAnywhere, Category = "Spawn Object")
+		TSoftClassPtr<APawn> PlayerRecharge;
+
+	// Pool
+	UPROPERTY(EditAnywhere, Category = "Spawn Object")
+		int32 PlayerRechargePoolPrewarm = 8;
+
+	UPROPERTY(EditAnywhere, Category = "Spawn Object")
+		int32 PlayerRechargePoolMax = 32;
+
+	// Maximum amount of recharges in the level at the same time
+	UPROPERTY(EditAnywhere, Category = "Spawn Object")
+		int32 MaxLiveRecharges = 6;
+
+	// Average time between two spawns (the spawns are a Poisson process, so the time between them varies)
+	UPROPERTY(EditAnywhere, Category = "Spawn Object")
+		float MeanSpawnInterval = 3.5f;
+
+	UPROPERTY(EditAnywhere, Category = "Spawn Object")
+		float MinSpawnInterval = 0.5f;
+
+	// Coordinates
+	UPROPERTY(EditAnywhere, Category = "Spawn Coordinates")
+		float Spawn_Z = 270.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Spawn Coordinates")
+		float Spawn_X_Min;
+
+	UPROPERTY(EditAnywhere, Category = "Spawn Coordinates")
+		float Spawn_X_Max;
+
+	UPROPERTY(EditAnywhere, Category = "Spawn Coordinates")
+		float Spawn_Y_Min;
+
+	UPROPERTY(EditAnywhere, Category = "Spawn Coordinates")
+		float Spawn_Y_Max;
+
+	// Size of a cell of the spawn grid, every cell holds at most one recharge
+	UPROPERTY(EditAnywhere, Category = "Spawn Coordinates")
+		float SpawnCellSize = 200.0f;
+
+	// How far below Spawn_Z the floor of a spawn point may be
+	UPROPERTY(EditAnywhere, Category = "Spawn Coordinates")
+		float MaxFloorDistance = 1000.0f;
+
+	// Half the height of the recharge, its centre spawns this far above the floor
+	UPROPERTY(EditAnywhere, Category = "Spawn Coordinates")
+		float RechargeHalfHeight = 50.0f;
+
+private:
+	void SpawnPlayerRecharge();
+	void ScheduleNextSpawn();
+
+	// Frees the spawn points of recharges that were collected or reset
+	void PruneLiveRecharges();
+
+	void OnSpawnPointTraced(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	// Creates the pool once the recharge class is loaded
+	void OnRechargeLoaded();
+
+	// Keeps the recharge class loaded
+	TSharedPtr<FStreamableHandle> RechargeAssets;
+
+	// Walkable spawn points between the coordinates
+	FSpawnPointGrid SpawnPoints;
+	FTraceDelegate SpawnPointTraceDelegate;
+
+	// Recharges in the level and the spawn point they occupy
+	TMap<TObjectKey<AActor>, int32> LiveRecharges;
+
+	FTimerHandle SpawnTimerHandle;
+
+	// Random stream of the spawn positions and interval
+	FRandomStream RechargeRandom;
+};
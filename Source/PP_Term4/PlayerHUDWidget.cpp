@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlayerHUDWidget.h"
+#include "Components/ProgressBar.h"
+#include "Components/TextBlock.h"
+
+#define LOCTEXT_NAMESPACE "PlayerHUDWidget"
+
+void UPlayerHUDWidget::SetDataSource(UHUDDataComponent* InDataSource)
+{
+	ClearDataSource();
+
+	DataSource = InDataSource;
+
+	if (!DataSource)
+		return;
+
+	DataSource->OnHealthChanged.AddDynamic(this, &UPlayerHUDWidget::OnHealthChanged);
+	DataSource->OnTimerSecondChanged.AddDynamic(this, &UPlayerHUDWidget::OnTimerSecondChanged);
+	DataSource->OnCoinsChanged.AddDynamic(this, &UPlayerHUDWidget::OnCoinsChanged);
+
+	// Show the values that were set before the widget subscribed
+	OnHealthChanged(DataSource->GetHealth());
+	OnTimerSecondChanged(DataSource->GetTimerSeconds());
+	OnCoinsChanged(DataSource->GetCollectedCoins(), DataSource->GetCoinsToCollect());
+}
+
+void UPlayerHUDWidget::NativeDestruct()
+{
+	ClearDataSource();
+
+	Super::NativeDestruct();
+}
+
+void UPlayerHUDWidget::OnHealthChanged(int32 Health)
+{
+	if (Health < 0)
+		return;
+
+	if (HealthText)
+		HealthText->SetText(FText::AsNumber(Health));
+
+	if (HealthBar && MaxHealth > 0.0f)
+		HealthBar->SetPercent(Health / MaxHealth);
+}
+
+void UPlayerHUDWidget::OnTimerSecondChanged(int32 Seconds)
+{
+	if (TimerText && Seconds >= 0)
+		TimerText->SetText(FText::AsNumber(Seconds));
+}
+
+void UPlayerHUDWidget::OnCoinsChanged(int32 Collected, int32 ToCollect)
+{
+	if (CoinsText && Collected >= 0)
+		CoinsText->SetText(FText::Format(LOCTEXT("Coins", "{0} / {1}"), Collected, ToCollect));
+}
+
+void UPlayerHUDWidget::ClearDataSource()
+{
+	if (DataSource)
+	{
+		DataSource->OnHealthChanged.RemoveAll(this);
+		DataSource->OnTimerSecondChanged.RemoveAll(this);
+		DataSource->OnCoinsChanged.RemoveAll(this);
+	}
+
+	DataSource = nullptr;
+}
+
+#undef LOCTEXT_NAMESPACE
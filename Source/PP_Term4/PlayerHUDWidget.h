@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+
+#include "HUDDataComponent.h"
+
+#include "PlayerHUDWidget.generated.h"
+
+class UProgressBar;
+class UTextBlock;
+
+/**
+ * Base class of the mini-game HUD widgets.
+ * Updates its optional text blocks and health bar from the delegates of a UHUDDataComponent,
+ * so nothing is bound per frame. Widgets in the designer only need to use the matching names.
+ * PlayerHealth_UI and PlayerCollect_UI have to be reparented to this class (and their property bindings removed),
+ * until then they keep polling every frame and the characters log a warning.
+ */
+UCLASS(Abstract)
+class PP_TERM4_API UPlayerHUDWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+	// Subscribes to the values of the component and shows the current ones
+	void SetDataSource(UHUDDataComponent* InDataSource);
+
+protected:
+	virtual void NativeDestruct() override;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+		UTextBlock* HealthText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+		UProgressBar* HealthBar;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+		UTextBlock* TimerText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+		UTextBlock* CoinsText;
+
+	// Maximum health, the health bar shows the health as a fraction of it
+	UPROPERTY(EditAnywhere, Category = "HUD")
+		float MaxHealth = 100.0f;
+
+private:
+	UFUNCTION()
+		void OnHealthChanged(int32 Health);
+
+	UFUNCTION()
+		void OnTimerSecondChanged(int32 Seconds);
+
+	UFUNCTION()
+		void OnCoinsChanged(int32 Collected, int32 ToCollect);
+
+	void ClearDataSource();
+
+	UPROPERTY()
+		UHUDDataComponent* DataSource;
+};
@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProgressSaveGame.h"
+
+// Identifies a progress save ("TLPS")
+static const uint32 ProgressSaveMagic = 0x53504C54;
+
+bool UProgressSaveGame::IsGameWon(FName GameMap) const
+{
+	const uint32 Bit = GetGameBit(GameMap);
+	return Bit != 0 && (WonGames & Bit) != 0;
+}
+
+bool UProgressSaveGame::MarkGameWon(FName GameMap)
+{
+	const uint32 Bit = GetGameBit(GameMap);
+
+	if (Bit == 0 || (WonGames & Bit) != 0)
+		return false;
+
+	WonGames |= Bit;
+	return true;
+}
+
+bool UProgressSaveGame::SerializeProgress(FArchive& Ar)
+{
+	uint32 Magic = ProgressSaveMagic;
+	uint16 Version = LatestVersion;
+
+	Ar << Magic;
+	Ar << Version;
+
+	if (Ar.IsError() || Magic != ProgressSaveMagic || Version == 0 || Version > LatestVersion)
+		return false;
+
+	// Version 1
+	Ar << WonGames;
+
+	return !Ar.IsError();
+}
+
+uint32 UProgressSaveGame::GetGameBit(FName GameMap)
+{
+	static const FName Game1(TEXT("Game1"));
+	static const FName Game2(TEXT("Game2"));
+
+	if (GameMap == Game1)
+		return 1 << 0;
+	if (GameMap == Game2)
+		return 1 << 1;
+
+	return 0;
+}
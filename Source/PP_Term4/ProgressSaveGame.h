@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/SaveGame.h"
+
+#include "ProgressSaveGame.generated.h"
+
+/**
+ * Progress of the player through the mini-games.
+ * Stored in its own compact binary format (see SerializeProgress) instead of the generic save game format.
+ */
+UCLASS()
+class PP_TERM4_API UProgressSaveGame : public USaveGame
+{
+	GENERATED_BODY()
+
+public:
+	// Bumped when the layout of SerializeProgress changes
+	static const uint16 LatestVersion = 1;
+
+	bool IsGameWon(FName GameMap) const;
+
+	// Returns true when the game wasn't marked as won yet
+	bool MarkGameWon(FName GameMap);
+
+	// Reads or writes the progress (returns false when the data isn't a progress save)
+	bool SerializeProgress(FArchive& Ar);
+
+private:
+	// Bit of the game in WonGames (0 for maps that aren't mini-games)
+	static uint32 GetGameBit(FName GameMap);
+
+	// One bit per mini-game
+	UPROPERTY()
+		uint32 WonGames = 0;
+};
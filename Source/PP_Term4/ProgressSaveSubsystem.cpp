@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProgressSaveSubsystem.h"
+#include "PP_Term4.h"
+#include "TheLabStats.h"
+#include "Async/Async.h"
+#include "Engine/GameInstance.h"
+#include "GameFramework/SaveGame.h"
+#include "HAL/FileManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/UnrealType.h"
+
+void UProgressSaveSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Progress = NewObject<UProgressSaveGame>(this);
+
+	bSaveInFlight = false;
+	bSavePending = false;
+	LastSerializeMilliseconds = 0.0;
+	LastWriteMilliseconds = 0.0;
+
+	// Load the progress once, the file is only a few bytes.
+	// Moving the temporary file over the save isn't atomic, so when a crash during the move left the save missing or
+	// unreadable, the temporary file still holds the complete progress.
+	if (ReadSave(GetSavePath()))
+		return;
+
+	if (ReadSave(GetTempSavePath()))
+	{
+		UE_LOG(LogTheLab, Warning, TEXT("Recovered the progress from %s"), *GetTempSavePath());
+		return;
+	}
+
+	// Before the progress file the blueprints saved to a save game slot, bring that progress over once
+	IFileManager& FileManager = IFileManager::Get();
+
+	if (!FileManager.FileExists(*GetSavePath()) && !FileManager.FileExists(*GetTempSavePath()) && ImportLegacySave())
+		SaveAsync();
+}
+
+void UProgressSaveSubsystem::Deinitialize()
+{
+	// Finish the save that is being written, and write the pending one before the game closes
+	if (SaveTask.IsValid())
+		SaveTask.Wait();
+
+	if (bSavePending)
+	{
+		TArray<uint8> Data;
+		FMemoryWriter Writer(Data);
+		Progress->SerializeProgress(Writer);
+
+		WriteSave(Data);
+	}
+
+	bSaveInFlight = false;
+	bSavePending = false;
+
+	Super::Deinitialize();
+}
+
+UProgressSaveSubsystem* UProgressSaveSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UGameInstance* GameInstance = UGameplayStatics::GetGameInstance(WorldContextObject);
+	return GameInstance ? GameInstance->GetSubsystem<UProgressSaveSubsystem>() : nullptr;
+}
+
+void UProgressSaveSubsystem::MarkGameWon(FName GameMap)
+{
+	Progress->MarkGameWon(GameMap);
+}
+
+void UProgressSaveSubsystem::SaveAsync()
+{
+	// Coalesce with the save that is being written, the follow-up save writes the latest progress
+	if (bSaveInFlight)
+	{
+		bSavePending = true;
+		return;
+	}
+
+	StartSave();
+}
+
+FString UProgressSaveSubsystem::GetSavePath()
+{
+	return FPaths::ProjectSavedDir() / TEXT("SaveGames") / TEXT("Progress.sav");
+}
+
+FString UProgressSaveSubsystem::GetTempSavePath()
+{
+	return GetSavePath() + TEXT(".tmp");
+}
+
+bool UProgressSaveSubsystem::ReadSave(const FString& Path)
+{
+	TArray<uint8> Data;
+
+	if (!FFileHelper::LoadFileToArray(Data, *Path, FILEREAD_Silent))
+		return false;
+
+	FMemoryReader Reader(Data);
+
+	if (!Progress->SerializeProgress(Reader))
+	{
+		UE_LOG(LogTheLab, Warning, TEXT("Ignoring unreadable progress save %s"), *Path);
+		Progress = NewObject<UProgressSaveGame>(this);
+		return false;
+	}
+
+	return true;
+}
+
+bool UProgressSaveSubsystem::ImportLegacySave()
+{
+	static const TCHAR* LegacySlot = TEXT("Slot1");
+
+	if (!UGameplayStatics::DoesSaveGameExist(LegacySlot, 0))
+		return false;
+
+	const USaveGame* LegacySave = UGameplayStatics::LoadGameFromSlot(LegacySlot, 0);
+
+	if (!LegacySave)
+	{
+		UE_LOG(LogTheLab, Warning, TEXT("Couldn't load the progress of save slot %s"), LegacySlot);
+		return false;
+	}
+
+	// Variables of the StatsSave blueprint and the game they stand for
+	static const TPair<FName, FName> LegacyGames[] =
+	{
+		{ FName(TEXT("Level1Finished")), FName(TEXT("Game1")) },
+		{ FName(TEXT("Level2Finished")), FName(TEXT("Game2")) }
+	};
+
+	for (const TPair<FName, FName>& LegacyGame : LegacyGames)
+	{
+		const FBoolProperty* Property = FindFProperty<FBoolProperty>(LegacySave->GetClass(), LegacyGame.Key);
+
+		if (Property && Property->GetPropertyValue_InContainer(LegacySave))
+			Progress->MarkGameWon(LegacyGame.Value);
+	}
+
+	UE_LOG(LogTheLab, Log, TEXT("Imported the progress of save slot %s (Game1 %s, Game2 %s)"), LegacySlot,
+		Progress->IsGameWon(TEXT("Game1")) ? TEXT("won") : TEXT("not won"), Progress->IsGameWon(TEXT("Game2")) ? TEXT("won") : TEXT("not won"));
+
+	return true;
+}
+
+bool UProgressSaveSubsystem::WriteSave(const TArray<uint8>& Data)
+{
+	const FString TempPath = GetTempSavePath();
+
+	if (!FFileHelper::SaveArrayToFile(Data, *TempPath))
+		return false;
+
+	// The move may delete the old save before the temporary file is renamed, loading falls back to the temporary file
+	return IFileManager::Get().Move(*GetSavePath(), *TempPath, true, true);
+}
+
+void UProgressSaveSubsystem::StartSave()
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_Save);
+
+	const double SerializeStartTime = FPlatformTime::Seconds();
+
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+	Progress->SerializeProgress(Writer);
+
+	LastSerializeMilliseconds = (FPlatformTime::Seconds() - SerializeStartTime) * 1000.0;
+
+	bSaveInFlight = true;
+	bSavePending = false;
+
+	TWeakObjectPtr<UProgressSaveSubsystem> WeakThis(this);
+
+	SaveTask = Async(EAsyncExecution::ThreadPool, [WeakThis, Data = MoveTemp(Data)]()
+	{
+		const double WriteStartTime = FPlatformTime::Seconds();
+		const bool bSuccess = WriteSave(Data);
+		const double WriteMilliseconds = (FPlatformTime::Seconds() - WriteStartTime) * 1000.0;
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, bSuccess, WriteMilliseconds]()
+		{
+			if (UProgressSaveSubsystem* This = WeakThis.Get())
+				This->OnSaveWritten(bSuccess, WriteMilliseconds);
+		});
+	});
+}
+
+void UProgressSaveSubsystem::OnSaveWritten(bool bSuccess, double WriteMilliseconds)
+{
+	bSaveInFlight = false;
+	LastWriteMilliseconds = WriteMilliseconds;
+
+	if (bSuccess)
+		UE_LOG(LogTheLab, Log, TEXT("Saved progress (serialize %.3f ms on the game thread, write %.2f ms on a worker)"), LastSerializeMilliseconds, LastWriteMilliseconds);
+	else
+		UE_LOG(LogTheLab, Warning, TEXT("Couldn't write progress save %s"), *GetSavePath());
+
+	if (bSavePending)
+		StartSave();
+}
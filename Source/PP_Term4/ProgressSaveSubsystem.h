@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Async/Future.h"
+
+#include "ProgressSaveGame.h"
+
+#include "ProgressSaveSubsystem.generated.h"
+
+/**
+ * Owns the progress of the player for the whole session.
+ * The progress is loaded once when the game starts. Saves are serialized on the game thread (a few bytes)
+ * and written on a worker thread to a temporary file that is then moved over the save, so a crash never
+ * leaves a half written save. A save requested while one is being written is coalesced into one follow-up save.
+ */
+UCLASS()
+class PP_TERM4_API UProgressSaveSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	static UProgressSaveSubsystem* Get(const UObject* WorldContextObject);
+
+	bool IsGameWon(FName GameMap) const { return Progress->IsGameWon(GameMap); }
+	void MarkGameWon(FName GameMap);
+
+	// Writes the progress without blocking the frame
+	void SaveAsync();
+
+	bool IsSaving() const { return bSaveInFlight; }
+
+	// Duration of the last save (serialize on the game thread, write on the worker)
+	double GetLastSerializeMilliseconds() const { return LastSerializeMilliseconds; }
+	double GetLastWriteMilliseconds() const { return LastWriteMilliseconds; }
+
+private:
+	static FString GetSavePath();
+	static FString GetTempSavePath();
+
+	// Reads the progress from the file, false (and empty progress) when it is missing or unreadable
+	bool ReadSave(const FString& Path);
+
+	// Takes the progress of the save game slot of the blueprints (returns false when there is none)
+	bool ImportLegacySave();
+
+	// Writes the data to the temporary file and moves it over the save (any thread)
+	static bool WriteSave(const TArray<uint8>& Data);
+
+	void StartSave();
+	void OnSaveWritten(bool bSuccess, double WriteMilliseconds);
+
+	UPROPERTY()
+		UProgressSaveGame* Progress;
+
+	// Save that is being written
+	TFuture<void> SaveTask;
+
+	bool bSaveInFlight;
+	bool bSavePending;
+
+	double LastSerializeMilliseconds;
+	double LastWriteMilliseconds;
+};
@@ -0,0 +1,183 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RoundResetSubsystem.h"
+#include "PP_Term4.h"
+#include "CoinFieldComponent.h"
+#include "PickupPoolSubsystem.h"
+#include "PickupRegistrySubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/Controller.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<bool> CVarInPlaceRestart(
+	TEXT("thelab.Round.InPlaceRestart"),
+	true,
+	TEXT("Retry a lost mini-game round by restoring its start state instead of reloading the map."));
+
+void URoundResetSubsystem::Deinitialize()
+{
+	Pickups.Empty();
+	PickupToIndex.Empty();
+	CoinFields.Empty();
+	Players.Empty();
+
+	Super::Deinitialize();
+}
+
+bool URoundResetSubsystem::IsInPlaceRestartEnabled()
+{
+	return CVarInPlaceRestart.GetValueOnGameThread();
+}
+
+void URoundResetSubsystem::Capture(ACharacter* Player)
+{
+	if (!Player)
+		return;
+
+	// The players of a level share its pickups, the ones that joined later don't record what was collected since
+	if (PickupLevel.Get() != Player->GetLevel())
+		CapturePickups(Player->GetLevel());
+
+	FPlayerSnapshot& Snapshot = Players.Add(Player);
+	Snapshot.Transform = Player->GetActorTransform();
+	Snapshot.MeshRelativeTransform = Player->GetMesh()->GetRelativeTransform();
+	Snapshot.ControlRotation = Player->GetController() ? Player->GetController()->GetControlRotation() : Player->GetActorRotation();
+	Snapshot.MeshCollisionProfile = Player->GetMesh()->GetCollisionProfileName();
+}
+
+void URoundResetSubsystem::CapturePickups(ULevel* Level)
+{
+	UInteractionSubsystem* InteractionSubsystem = GetWorld()->GetSubsystem<UInteractionSubsystem>();
+	UPickupRegistrySubsystem* PickupRegistry = GetWorld()->GetSubsystem<UPickupRegistrySubsystem>();
+
+	Pickups.Reset();
+	PickupToIndex.Reset();
+	CoinFields.Reset();
+	PickupLevel = Level;
+
+	// Pickups placed in the level (spawned pickups are pooled, they are released on restore)
+	for (AActor* Actor : Level->Actors)
+	{
+		if (!Actor)
+			continue;
+
+		if (UCoinFieldComponent* CoinField = Actor->FindComponentByClass<UCoinFieldComponent>())
+			CoinFields.Add(CoinField);
+
+		const EInteractionType Type = InteractionSubsystem->GetInteractionType(Actor);
+
+		if (Type != EInteractionType::Coin && Type != EInteractionType::Recharge)
+			continue;
+
+		FPickupSnapshot& Snapshot = Pickups.AddDefaulted_GetRef();
+		Snapshot.Actor = Actor;
+		Snapshot.Transform = Actor->GetActorTransform();
+		Snapshot.Type = Type;
+		Snapshot.bHidden = Actor->IsHidden();
+		Snapshot.bCollisionEnabled = Actor->GetActorEnableCollision();
+		Snapshot.bRegistered = PickupRegistry && PickupRegistry->IsRegistered(Actor);
+
+		PickupToIndex.Add(Actor, Pickups.Num() - 1);
+	}
+}
+
+bool URoundResetSubsystem::Consume(AActor* Pickup)
+{
+	if (!PickupToIndex.Contains(Pickup))
+		return false;
+
+	SetPickupActive(Pickup, false, false);
+	return true;
+}
+
+void URoundResetSubsystem::RestorePickups()
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	UPickupRegistrySubsystem* PickupRegistry = GetWorld()->GetSubsystem<UPickupRegistrySubsystem>();
+
+	// Spawned pickups go back to their pool
+	if (UPickupPoolSubsystem* PickupPool = GetWorld()->GetSubsystem<UPickupPoolSubsystem>())
+	{
+		TArray<AActor*> Released;
+		PickupPool->ReleaseAll(Released);
+
+		if (PickupRegistry)
+		{
+			for (AActor* Actor : Released)
+				PickupRegistry->Unregister(Actor);
+		}
+	}
+
+	// Placed pickups
+	for (const FPickupSnapshot& Snapshot : Pickups)
+	{
+		if (!IsValid(Snapshot.Actor))
+			continue;
+
+		Snapshot.Actor->SetActorTransform(Snapshot.Transform, false, nullptr, ETeleportType::ResetPhysics);
+		SetPickupActive(Snapshot.Actor, !Snapshot.bHidden, Snapshot.bCollisionEnabled);
+
+		if (Snapshot.bRegistered && PickupRegistry)
+		{
+			PickupRegistry->Unregister(Snapshot.Actor);
+			PickupRegistry->Register(Snapshot.Actor, Snapshot.Type);
+		}
+	}
+
+	for (const TWeakObjectPtr<UCoinFieldComponent>& CoinField : CoinFields)
+	{
+		if (CoinField.IsValid())
+			CoinField->ResetCoins();
+	}
+
+	UE_LOG(LogTheLab, Log, TEXT("Restored the pickups of the round (%d placed) in %.2f ms"), Pickups.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+void URoundResetSubsystem::RestorePlayer(ACharacter* Player)
+{
+	const FPlayerSnapshot* Snapshot = Players.Find(Player);
+
+	if (!Snapshot)
+		return;
+
+	RestorePlayerMesh(Player);
+
+	Player->GetCharacterMovement()->StopMovementImmediately();
+	Player->SetActorTransform(Snapshot->Transform, false, nullptr, ETeleportType::ResetPhysics);
+
+	if (AController* Controller = Player->GetController())
+		Controller->SetControlRotation(Snapshot->ControlRotation);
+}
+
+void URoundResetSubsystem::RestorePlayerMesh(ACharacter* Player)
+{
+	const FPlayerSnapshot* Snapshot = Players.Find(Player);
+
+	if (!Snapshot)
+		return;
+
+	// The mesh is put back on the capsule when it was a ragdoll
+	USkeletalMeshComponent* Mesh = Player->GetMesh();
+
+	if (Mesh->IsSimulatingPhysics())
+	{
+		Mesh->SetSimulatePhysics(false);
+		Mesh->AttachToComponent(Player->GetCapsuleComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+		Mesh->SetCollisionProfileName(Snapshot->MeshCollisionProfile);
+	}
+
+	Mesh->SetRelativeTransform(Snapshot->MeshRelativeTransform, false, nullptr, ETeleportType::ResetPhysics);
+}
+
+void URoundResetSubsystem::SetPickupActive(AActor* Pickup, bool bActive, bool bCollisionEnabled)
+{
+	Pickup->SetActorHiddenInGame(!bActive);
+	Pickup->SetActorEnableCollision(bActive && bCollisionEnabled);
+	Pickup->SetActorTickEnabled(bActive && Pickup->PrimaryActorTick.bStartWithTickEnabled);
+}
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameFramework/Character.h"
+
+#include "InteractionSubsystem.h"
+
+#include "RoundResetSubsystem.generated.h"
+
+class UCoinFieldComponent;
+
+// State of a placed pickup when the round started
+USTRUCT()
+struct FPickupSnapshot
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		AActor* Actor = nullptr;
+
+	FTransform Transform;
+	EInteractionType Type = EInteractionType::None;
+
+	bool bHidden = false;
+	bool bCollisionEnabled = true;
+
+	// Collected by the pickup registry instead of overlap events
+	bool bRegistered = false;
+};
+
+// Start of the round of a player
+struct FPlayerSnapshot
+{
+	FTransform Transform;
+	FTransform MeshRelativeTransform;
+	FRotator ControlRotation;
+	FName MeshCollisionProfile;
+};
+
+/**
+ * Snapshots the start of a mini-game round, so a retry restores it in one frame instead of reloading the map.
+ * The pickups placed in the level of the players and its coin fields are shared by every player of the level, and the
+ * start transform is kept per player, so the round of one player can be reset without moving the others.
+ * Collected pickups are deactivated instead of destroyed, and pooled pickups go back to their pool on restore.
+ * The character restores its own round values (health, timer) after restoring its snapshot.
+ */
+UCLASS()
+class PP_TERM4_API URoundResetSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Returns true when a retry restores the snapshot instead of reloading the map
+	static bool IsInPlaceRestartEnabled();
+
+	// Records the player, and the pickups placed in the player's level when they weren't recorded for another player
+	void Capture(ACharacter* Player);
+
+	// Deactivates a pickup of the snapshot (returns false when it isn't part of the snapshot)
+	bool Consume(AActor* Pickup);
+
+	// Puts the pickups back in their captured state and the spawned pickups back in their pool (for every player)
+	void RestorePickups();
+
+	// Puts the player back where its round started, with the mesh on the capsule again
+	void RestorePlayer(ACharacter* Player);
+
+	// Only puts the mesh of the player back on its capsule (on a client, the server moves the player)
+	void RestorePlayerMesh(ACharacter* Player);
+
+	bool HasSnapshot(const ACharacter* Player) const { return Players.Contains(Player); }
+
+private:
+	static void SetPickupActive(AActor* Pickup, bool bActive, bool bCollisionEnabled);
+
+	void CapturePickups(ULevel* Level);
+
+	UPROPERTY()
+		TArray<FPickupSnapshot> Pickups;
+
+	TMap<TObjectKey<AActor>, int32> PickupToIndex;
+
+	// Instanced coins, every coin is shown again on restore
+	TArray<TWeakObjectPtr<UCoinFieldComponent>> CoinFields;
+
+	// Level the pickups were recorded in
+	TWeakObjectPtr<ULevel> PickupLevel;
+
+	TMap<TObjectKey<ACharacter>, FPlayerSnapshot> Players;
+};
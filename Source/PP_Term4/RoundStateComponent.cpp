@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RoundStateComponent.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+
+// Sets default values for this component's properties
+URoundStateComponent::URoundStateComponent()
+{
+	// Everything is event driven, so it never has to tick
+	PrimaryComponentTick.bCanEverTick = false;
+
+	State = ERoundState::Playing;
+	ScheduledOutcome = ERoundState::Lost;
+}
+
+// Called when the game ends or the owner is destroyed
+void URoundStateComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ClearScheduledOutcome();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void URoundStateComponent::ScheduleOutcome(ERoundState Outcome, float Delay)
+{
+	check(Outcome == ERoundState::Won || Outcome == ERoundState::Lost);
+
+	if (!IsPlaying())
+		return;
+
+	ScheduledOutcome = Outcome;
+
+	if (Delay <= 0.0f)
+		FinishRound(Outcome);
+	else
+		GetWorld()->GetTimerManager().SetTimer(OutcomeTimerHandle, this, &URoundStateComponent::OnOutcomeTimer, Delay, false);
+}
+
+void URoundStateComponent::ClearScheduledOutcome()
+{
+	if (UWorld* World = GetWorld())
+		World->GetTimerManager().ClearTimer(OutcomeTimerHandle);
+}
+
+float URoundStateComponent::GetScheduledOutcomeRemaining() const
+{
+	const float Remaining = GetWorld()->GetTimerManager().GetTimerRemaining(OutcomeTimerHandle);
+
+	return FMath::Max(Remaining, 0.0f);
+}
+
+bool URoundStateComponent::FinishRound(ERoundState Outcome)
+{
+	check(Outcome == ERoundState::Won || Outcome == ERoundState::Lost);
+
+	if (!IsPlaying())
+		return false;
+
+	ClearScheduledOutcome();
+	SetState(Outcome);
+
+	return true;
+}
+
+bool URoundStateComponent::BeginTransition()
+{
+	if (State != ERoundState::Won && State != ERoundState::Lost)
+		return false;
+
+	SetState(ERoundState::Transitioning);
+
+	return true;
+}
+
+void URoundStateComponent::ResetRound()
+{
+	ClearScheduledOutcome();
+	State = ERoundState::Playing;
+}
+
+void URoundStateComponent::OnOutcomeTimer()
+{
+	FinishRound(ScheduledOutcome);
+}
+
+void URoundStateComponent::SetState(ERoundState NewState)
+{
+	const ERoundState OldState = State;
+	State = NewState;
+
+	OnStateChanged.Broadcast(OldState, NewState);
+}
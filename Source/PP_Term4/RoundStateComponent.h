@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Engine/EngineTypes.h"
+
+#include "RoundStateComponent.generated.h"
+
+UENUM(BlueprintType)
+enum class ERoundState : uint8
+{
+	Playing,
+	Won,
+	Lost,
+	Transitioning
+};
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnRoundStateChanged, ERoundState /*OldState*/, ERoundState /*NewState*/);
+
+/**
+ * State of a mini-game round (Playing -> Won/Lost -> Transitioning).
+ * Transitions are driven by events or by one scheduled timer, and every transition fires exactly once.
+ */
+UCLASS(ClassGroup = (TheLab), meta = (BlueprintSpawnableComponent))
+class PP_TERM4_API URoundStateComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	URoundStateComponent();
+
+protected:
+	// Called when the game ends or the owner is destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	UFUNCTION(BlueprintPure, Category = "Round")
+		ERoundState GetState() const { return State; }
+
+	UFUNCTION(BlueprintPure, Category = "Round")
+		bool IsPlaying() const { return State == ERoundState::Playing; }
+
+	// Ends the round with the outcome after the delay (replaces the previously scheduled outcome)
+	void ScheduleOutcome(ERoundState Outcome, float Delay);
+	void ClearScheduledOutcome();
+
+	// Seconds until the scheduled outcome (0 when nothing is scheduled)
+	float GetScheduledOutcomeRemaining() const;
+
+	// Ends the round with Won or Lost (returns false when the round already ended)
+	bool FinishRound(ERoundState Outcome);
+
+	// Moves an ended round to Transitioning (returns false when it isn't ended or already transitioning)
+	bool BeginTransition();
+
+	// Puts the round back in Playing without broadcasting
+	void ResetRound();
+
+	// Called on every state change
+	FOnRoundStateChanged OnStateChanged;
+
+private:
+	void OnOutcomeTimer();
+
+	void SetState(ERoundState NewState);
+
+	ERoundState State;
+	ERoundState ScheduledOutcome;
+
+	FTimerHandle OutcomeTimerHandle;
+};
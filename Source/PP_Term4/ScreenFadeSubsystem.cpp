@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ScreenFadeSubsystem.h"
+#include "TheLabStats.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "TimerManager.h"
+
+static TAutoConsoleVariable<float> CVarFadeDuration(
+	TEXT("thelab.Fade.Duration"),
+	0.83f,
+	TEXT("Duration of the screen fades between levels and rounds (in seconds)."));
+
+void UScreenFadeSubsystem::FadeOut(FOnFadeFinished OnFinished, float Duration)
+{
+	StartFade(0.0f, 1.0f, Duration, true, OnFinished);
+}
+
+void UScreenFadeSubsystem::FadeIn(FOnFadeFinished OnFinished, float Duration)
+{
+	StartFade(1.0f, 0.0f, Duration, false, OnFinished);
+}
+
+bool UScreenFadeSubsystem::IsFading() const
+{
+	return GetWorld()->GetTimerManager().IsTimerActive(FadeTimerHandle);
+}
+
+float UScreenFadeSubsystem::GetDefaultDuration()
+{
+	return FMath::Max(CVarFadeDuration.GetValueOnGameThread(), 0.0f);
+}
+
+void UScreenFadeSubsystem::StartFade(float FromAlpha, float ToAlpha, float Duration, bool bHoldWhenFinished, FOnFadeFinished OnFinished)
+{
+	THELAB_SCOPE_CYCLE_COUNTER(STAT_TheLab_Fade);
+
+	if (Duration < 0.0f)
+		Duration = GetDefaultDuration();
+
+	// A new fade replaces the running one, which still finishes so whatever waits on it isn't dropped
+	if (IsFading())
+		OnFadeTimer();
+
+	OnFadeFinished = OnFinished;
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+
+	if (PlayerController && PlayerController->PlayerCameraManager)
+		PlayerController->PlayerCameraManager->StartCameraFade(FromAlpha, ToAlpha, Duration, FLinearColor::Black, false, bHoldWhenFinished);
+	else
+		Duration = 0.0f;
+
+	// The camera manager has no completion event, so the end of the fade is a timer of the same length
+	if (Duration > 0.0f)
+		GetWorld()->GetTimerManager().SetTimer(FadeTimerHandle, this, &UScreenFadeSubsystem::OnFadeTimer, Duration, false);
+	else
+		OnFadeTimer();
+}
+
+void UScreenFadeSubsystem::OnFadeTimer()
+{
+	GetWorld()->GetTimerManager().ClearTimer(FadeTimerHandle);
+
+	// Copy first, the callback is allowed to start the next fade
+	const FOnFadeFinished Finished = OnFadeFinished;
+	OnFadeFinished.Unbind();
+
+	Finished.ExecuteIfBound();
+}
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineTypes.h"
+
+#include "ScreenFadeSubsystem.generated.h"
+
+// Called when a fade is done
+DECLARE_DELEGATE(FOnFadeFinished);
+
+/**
+ * Fades the screen of the first player through the camera manager.
+ * A fade out holds the faded screen until the next fade in, and the callback fires when the fade is done,
+ * so transitions start at the end of the fade instead of after a fixed delay.
+ * Without a camera manager (no player yet) the callback fires right away.
+ * A fade started while another one runs replaces it, the callback of the replaced fade fires first.
+ */
+UCLASS()
+class PP_TERM4_API UScreenFadeSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Fades to black (Duration < 0 uses thelab.Fade.Duration)
+	void FadeOut(FOnFadeFinished OnFinished = FOnFadeFinished(), float Duration = -1.0f);
+
+	// Fades from black (Duration < 0 uses thelab.Fade.Duration)
+	void FadeIn(FOnFadeFinished OnFinished = FOnFadeFinished(), float Duration = -1.0f);
+
+	// Returns true while a fade is running
+	bool IsFading() const;
+
+	// Duration of a fade with the default duration (thelab.Fade.Duration)
+	static float GetDefaultDuration();
+
+private:
+	void StartFade(float FromAlpha, float ToAlpha, float Duration, bool bHoldWhenFinished, FOnFadeFinished OnFinished);
+	void OnFadeTimer();
+
+	FTimerHandle FadeTimerHandle;
+
+	FOnFadeFinished OnFadeFinished;
+};
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SpawnPointGrid.h"
+#include "PP_Term4.h"
+#include "CollisionQueryParams.h"
+#include "HAL/PlatformTime.h"
+
+// Same as the default walkable floor angle of the character movement (~45 degrees)
+static const float WalkableFloorZ = 0.71f;
+
+FSpawnPointGrid::FSpawnPointGrid()
+{
+	SpawnHeightAboveFloor = 0.0f;
+	PendingTraces = 0;
+	BuildStartTime = 0.0;
+}
+
+void FSpawnPointGrid::Build(UWorld* World, const FBox2D& Bounds, float Height, float CellSize, float MaxFloorDistance, float HeightAboveFloor, const FTraceDelegate& OnTraceDone)
+{
+	Points.Reset();
+	FreeCells.Reset();
+	FreeIndices.Reset();
+	PendingTraces = 0;
+	SpawnHeightAboveFloor = HeightAboveFloor;
+
+	if (!World || !Bounds.bIsValid || CellSize <= 0.0f)
+		return;
+
+	BuildStartTime = FPlatformTime::Seconds();
+
+	// Only static geometry counts as floor, so pawns and pickups standing in the way don't
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(SpawnPointGrid), false);
+	const FCollisionObjectQueryParams ObjectParams(ECC_WorldStatic);
+
+	const int32 NumX = FMath::Max(FMath::FloorToInt(Bounds.GetSize().X / CellSize), 1);
+	const int32 NumY = FMath::Max(FMath::FloorToInt(Bounds.GetSize().Y / CellSize), 1);
+
+	// Every trace of the grid is queued in the same frame and runs on the async trace tasks
+	for (int32 X = 0; X < NumX; X++)
+	{
+		for (int32 Y = 0; Y < NumY; Y++)
+		{
+			const FVector Start(Bounds.Min.X + (X + 0.5f) * CellSize, Bounds.Min.Y + (Y + 0.5f) * CellSize, Height);
+			const FVector End = Start - FVector(0.0f, 0.0f, MaxFloorDistance);
+
+			World->AsyncLineTraceByObjectType(EAsyncTraceType::Single, Start, End, ObjectParams, QueryParams, &OnTraceDone);
+			PendingTraces++;
+		}
+	}
+}
+
+bool FSpawnPointGrid::HandleTrace(const FTraceDatum& TraceDatum)
+{
+	if (PendingTraces <= 0)
+		return false;
+
+	// Keep the cell when there is walkable floor below it, the actor stands on the floor
+	const FHitResult* Hit = TraceDatum.OutHits.Num() > 0 ? &TraceDatum.OutHits[0] : nullptr;
+
+	if (Hit && Hit->bBlockingHit && Hit->ImpactNormal.Z >= WalkableFloorZ)
+	{
+		FreeIndices.Add(FreeCells.Num());
+		FreeCells.Add(Points.Num());
+		Points.Add(Hit->ImpactPoint + FVector(0.0f, 0.0f, SpawnHeightAboveFloor));
+	}
+
+	if (--PendingTraces > 0)
+		return false;
+
+	UE_LOG(LogTheLab, Log, TEXT("Spawn point grid: %d walkable points baked in %.2f ms"),
+		Points.Num(), (FPlatformTime::Seconds() - BuildStartTime) * 1000.0);
+
+	return true;
+}
+
+int32 FSpawnPointGrid::TakeRandom(FRandomStream& Random)
+{
+	if (FreeCells.Num() == 0)
+		return INDEX_NONE;
+
+	const int32 Index = Random.RandRange(0, FreeCells.Num() - 1);
+	const int32 Cell = FreeCells[Index];
+
+	// Move the last free cell into the gap
+	FreeCells.RemoveAtSwap(Index, 1, false);
+
+	if (FreeCells.IsValidIndex(Index))
+		FreeIndices[FreeCells[Index]] = Index;
+
+	FreeIndices[Cell] = INDEX_NONE;
+
+	return Cell;
+}
+
+void FSpawnPointGrid::Release(int32 Cell)
+{
+	if (!FreeIndices.IsValidIndex(Cell) || FreeIndices[Cell] != INDEX_NONE)
+		return;
+
+	FreeIndices[Cell] = FreeCells.Add(Cell);
+}
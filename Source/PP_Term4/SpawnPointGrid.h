@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/World.h"
+
+/**
+ * Grid of spawn points over walkable floor, baked once with async line traces.
+ * Every cell holds at most one spawned actor, so the cell size sets the spawn density,
+ * and a free cell is taken and returned in O(1).
+ */
+struct PP_TERM4_API FSpawnPointGrid
+{
+public:
+	FSpawnPointGrid();
+
+	// Traces down through the centre of every cell of the bounds at the given height, the results arrive through OnTraceDone
+	// (the spawn point of a cell is HeightAboveFloor above the floor it hit, the half height of the spawned actor)
+	void Build(UWorld* World, const FBox2D& Bounds, float Height, float CellSize, float MaxFloorDistance, float HeightAboveFloor, const FTraceDelegate& OnTraceDone);
+
+	// Adds the cell of a finished trace when it hit walkable floor (returns true when this was the last trace)
+	bool HandleTrace(const FTraceDatum& TraceDatum);
+
+	bool IsBuilt() const { return PendingTraces == 0 && Points.Num() > 0; }
+
+	// Takes a random free cell (returns INDEX_NONE when every cell is in use)
+	int32 TakeRandom(FRandomStream& Random);
+
+	// Gives the cell back
+	void Release(int32 Cell);
+
+	const FVector& GetLocation(int32 Cell) const { return Points[Cell]; }
+
+	int32 GetNumPoints() const { return Points.Num(); }
+	int32 GetNumFree() const { return FreeCells.Num(); }
+
+private:
+	// Spawn locations of the walkable cells
+	TArray<FVector> Points;
+
+	// Cells without an actor, and the index of every cell in it (INDEX_NONE when it is in use)
+	TArray<int32> FreeCells;
+	TArray<int32> FreeIndices;
+
+	float SpawnHeightAboveFloor;
+
+	int32 PendingTraces;
+	double BuildStartTime;
+};
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TheLabCollision.h"
+#include "PP_Term4.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/Character.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<bool> CVarCollisionProfiles(
+	TEXT("thelab.Collision.Profiles"),
+	true,
+	TEXT("Puts the player characters and the interactables on the dedicated collision profiles when they begin play.\n")
+	TEXT("0 keeps the collision of their blueprints (for comparing the overlap cost with -TheLabBenchmark)."));
+
+const FName FTheLabCollision::CharacterProfile(TEXT("TheLabCharacter"));
+const FName FTheLabCollision::PickupProfile(TEXT("Pickup"));
+const FName FTheLabCollision::LevelTriggerProfile(TEXT("LevelTrigger"));
+const FName FTheLabCollision::EndTriggerProfile(TEXT("EndTrigger"));
+
+bool FTheLabCollision::AreProfilesEnabled()
+{
+	return CVarCollisionProfiles.GetValueOnGameThread();
+}
+
+FName FTheLabCollision::GetProfileName(EInteractionType Type)
+{
+	switch (Type)
+	{
+	case EInteractionType::Coin:
+	case EInteractionType::Recharge:
+		return PickupProfile;
+
+	case EInteractionType::Game1:
+	case EInteractionType::Game2:
+		return LevelTriggerProfile;
+
+	case EInteractionType::End:
+		return EndTriggerProfile;
+
+	default:
+		return NAME_None;
+	}
+}
+
+ECollisionChannel FTheLabCollision::GetObjectChannel(EInteractionType Type)
+{
+	switch (Type)
+	{
+	case EInteractionType::Coin:
+	case EInteractionType::Recharge:
+		return COLLISION_PICKUP;
+
+	case EInteractionType::Game1:
+	case EInteractionType::Game2:
+		return COLLISION_LEVELTRIGGER;
+
+	case EInteractionType::End:
+		return COLLISION_ENDTRIGGER;
+
+	default:
+		return ECC_WorldDynamic;
+	}
+}
+
+void FTheLabCollision::ApplyInteractableProfile(AActor* Actor, EInteractionType Type)
+{
+	if (!Actor || Type == EInteractionType::None || !AreProfilesEnabled())
+		return;
+
+	TInlineComponentArray<UPrimitiveComponent*> Primitives(Actor);
+
+	for (UPrimitiveComponent* Primitive : Primitives)
+		ApplyInteractableProfile(Primitive, Type);
+}
+
+void FTheLabCollision::ApplyInteractableProfile(UPrimitiveComponent* Primitive, EInteractionType Type)
+{
+	if (!Primitive || Type == EInteractionType::None || !AreProfilesEnabled())
+		return;
+
+	// The shape the player touches is the one that overlaps pawns (already on the profile when it is applied again)
+	if (Primitive->GetCollisionObjectType() == GetObjectChannel(Type) || Primitive->GetCollisionResponseToChannel(ECC_Pawn) == ECR_Overlap)
+		SetProfile(Primitive, GetProfileName(Type));
+}
+
+void FTheLabCollision::ApplyCharacterProfile(ACharacter* Character)
+{
+	if (Character && AreProfilesEnabled())
+		SetProfile(Character->GetCapsuleComponent(), CharacterProfile);
+}
+
+void FTheLabCollision::SetProfile(UPrimitiveComponent* Primitive, FName ProfileName)
+{
+	// Without the profiles in the config the blueprint collision still works, so keep it
+	FCollisionResponseTemplate Template;
+
+	if (!UCollisionProfile::Get()->GetProfileTemplate(ProfileName, Template))
+	{
+		static bool bWarned = false;
+
+		if (!bWarned)
+		{
+			UE_LOG(LogTheLab, Warning, TEXT("Collision profile %s is missing from DefaultEngine.ini, keeping the collision of the blueprints"), *ProfileName.ToString());
+			bWarned = true;
+		}
+
+		return;
+	}
+
+	if (Primitive->GetCollisionProfileName() != ProfileName)
+		Primitive->SetCollisionProfileName(ProfileName);
+}
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+
+#include "InteractionSubsystem.h"
+
+class ACharacter;
+class UPrimitiveComponent;
+
+// Object channels of the interactables, declared in Config/DefaultEngine.ini (nothing but the player characters responds to them)
+#define COLLISION_PICKUP		ECC_GameTraceChannel1
+#define COLLISION_LEVELTRIGGER	ECC_GameTraceChannel2
+#define COLLISION_ENDTRIGGER	ECC_GameTraceChannel3
+
+/**
+ * Collision profiles of the player characters and the things they interact with.
+ * The interactables are on their own object channels and only overlap pawns, and the capsule of a player character
+ * only overlaps those channels, so the broadphase doesn't produce pairs (and overlap events) the handlers would ignore.
+ * thelab.Collision.Profiles 0 keeps the collision of the blueprints instead, for comparing the overlap cost.
+ */
+struct PP_TERM4_API FTheLabCollision
+{
+	static const FName CharacterProfile;
+	static const FName PickupProfile;
+	static const FName LevelTriggerProfile;
+	static const FName EndTriggerProfile;
+
+	static bool AreProfilesEnabled();
+
+	// Profile of the interactables of the type (NAME_None for None)
+	static FName GetProfileName(EInteractionType Type);
+
+	// Object channel of the interactables of the type (ECC_WorldDynamic for None)
+	static ECollisionChannel GetObjectChannel(EInteractionType Type);
+
+	// Puts the shapes of the actor the player overlaps on the profile of the type (meshes that block keep their collision)
+	static void ApplyInteractableProfile(AActor* Actor, EInteractionType Type);
+	static void ApplyInteractableProfile(UPrimitiveComponent* Primitive, EInteractionType Type);
+
+	// Puts the capsule of the player character on the character profile
+	static void ApplyCharacterProfile(ACharacter* Character);
+
+private:
+	static void SetProfile(UPrimitiveComponent* Primitive, FName ProfileName);
+};
@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TheLabStats.h"
+
+DEFINE_STAT(STAT_TheLab_Overlap);
+DEFINE_STAT(STAT_TheLab_PickupQuery);
+DEFINE_STAT(STAT_TheLab_SpawnRecharge);
+DEFINE_STAT(STAT_TheLab_RefreshDisplay);
+DEFINE_STAT(STAT_TheLab_CreateWidget);
+DEFINE_STAT(STAT_TheLab_Fade);
+DEFINE_STAT(STAT_TheLab_Save);
+DEFINE_STAT(STAT_TheLab_LevelTransition);
+DEFINE_STAT(STAT_TheLab_RoundReset);
+DEFINE_STAT(STAT_TheLab_FeedbackEffect);
+DEFINE_STAT(STAT_TheLab_MazeGenerate);
+DEFINE_STAT(STAT_TheLab_SwarmAnimate);
+DEFINE_STAT(STAT_TheLab_SwarmCollect);
+DEFINE_STAT(STAT_TheLab_SwarmUpload);
+DEFINE_STAT(STAT_TheLab_GhostRecord);
+DEFINE_STAT(STAT_TheLab_GhostPlayback);
+
+DEFINE_STAT(STAT_TheLab_RegisteredPickups);
+DEFINE_STAT(STAT_TheLab_ActivePooledPickups);
+DEFINE_STAT(STAT_TheLab_HUDWidgets);
+DEFINE_STAT(STAT_TheLab_SignificanceHigh);
+DEFINE_STAT(STAT_TheLab_SignificanceMedium);
+DEFINE_STAT(STAT_TheLab_SignificanceLow);
+DEFINE_STAT(STAT_TheLab_SwarmPickups);
+DEFINE_STAT(STAT_TheLab_Ghosts);
+DEFINE_STAT(STAT_TheLab_GhostRecordingBytes);
+
+UE_TRACE_CHANNEL_DEFINE(TheLabChannel);
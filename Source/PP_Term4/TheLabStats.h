@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
+
+// "stat TheLab" shows the cost of the gameplay code of the module
+DECLARE_STATS_GROUP(TEXT("TheLab"), STATGROUP_TheLab, STATCAT_Advanced);
+
+// Cycle counters
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Overlap handlers"), STAT_TheLab_Overlap, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pickup registry query"), STAT_TheLab_PickupQuery, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn recharge"), STAT_TheLab_SpawnRecharge, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Refresh timer / health"), STAT_TheLab_RefreshDisplay, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Create widget"), STAT_TheLab_CreateWidget, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Start fade"), STAT_TheLab_Fade, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Save progress"), STAT_TheLab_Save, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Level transition"), STAT_TheLab_LevelTransition, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Round reset"), STAT_TheLab_RoundReset, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Play feedback effect"), STAT_TheLab_FeedbackEffect, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Generate maze"), STAT_TheLab_MazeGenerate, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Swarm animate"), STAT_TheLab_SwarmAnimate, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Swarm collect"), STAT_TheLab_SwarmCollect, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Swarm upload instances"), STAT_TheLab_SwarmUpload, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ghost record"), STAT_TheLab_GhostRecord, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ghost playback"), STAT_TheLab_GhostPlayback, STATGROUP_TheLab, PP_TERM4_API);
+
+// Counters
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Registered pickups"), STAT_TheLab_RegisteredPickups, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Active pooled pickups"), STAT_TheLab_ActivePooledPickups, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("HUD widgets"), STAT_TheLab_HUDWidgets, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Significance high"), STAT_TheLab_SignificanceHigh, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Significance medium"), STAT_TheLab_SignificanceMedium, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Significance low"), STAT_TheLab_SignificanceLow, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Swarm pickups"), STAT_TheLab_SwarmPickups, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Ghosts"), STAT_TheLab_Ghosts, STATGROUP_TheLab, PP_TERM4_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Ghost recording bytes"), STAT_TheLab_GhostRecordingBytes, STATGROUP_TheLab, PP_TERM4_API);
+
+// Insights channel of the module ("-trace=cpu,TheLab")
+UE_TRACE_CHANNEL_EXTERN(TheLabChannel, PP_TERM4_API);
+
+// Times the scope in the stat group and as an event on the TheLab trace channel (both are compiled out in Shipping)
+#define THELAB_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR(#Stat, TheLabChannel)